@@ -0,0 +1,202 @@
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <linux/limits.h>
+#include <nlohmann/json.hpp>
+#include <print>
+#include <string>
+#include <sys/types.h>
+#include <unistd.h>
+#include <vector>
+
+#include "commands.hpp"
+#include "decode.hpp"
+#include "launcher.hpp"
+#include "matcher.hpp"
+#include "utils.hpp"
+
+// Microbenchmarks for the per-refresh hot paths, built with
+// -DHYPRDOCK_BUILD_BENCH=ON. Inputs are synthetic so no compositor is needed.
+
+#define BENCH_CLASSES 50
+#define BENCH_CLIENTS 200
+
+// Pinned app counts the running-app resolution is measured at
+static constexpr std::array<size_t, 5> BENCH_PINNED{1, 5, 10, 20, 50};
+
+using json = nlohmann::json;
+
+// Keeps results alive so the measured work is not optimized away
+static volatile size_t sink = 0;
+
+// Average microseconds per call over enough calls to fill about half a second
+template <typename F> static double measure(F &&function) {
+  using Clock = std::chrono::steady_clock;
+
+  size_t iterations = 1;
+  while (true) {
+    auto start = Clock::now();
+    for (size_t i = 0; i < iterations; i++)
+      function();
+    std::chrono::duration<double, std::micro> elapsed = Clock::now() - start;
+
+    if (elapsed.count() >= 500000.0 || iterations >= (size_t{1} << 30))
+      return elapsed.count() / iterations;
+    iterations *= 2;
+  }
+}
+
+static std::vector<DesktopEntry> make_apps(size_t count) {
+  std::vector<DesktopEntry> apps;
+  for (size_t i = 0; i < count; i++) {
+    DesktopEntry app;
+    app.id = "org.example.app" + std::to_string(i);
+    app.name = "App " + std::to_string(i);
+    app.exec = "/usr/bin/app" + std::to_string(i) + " %U";
+    apps.push_back(std::move(app));
+  }
+
+  return apps;
+}
+
+// Windows spread over BENCH_CLASSES window classes, the first apps pinned
+// share theirs. Every window is owned by this process, so reading the
+// executable of its pid costs a real readlink.
+static std::vector<Client> make_clients(size_t count) {
+  std::vector<Client> clients;
+  for (size_t i = 0; i < count; i++) {
+    size_t app = i % BENCH_CLASSES;
+    clients.push_back(Client{
+        .address = "0x" + std::to_string(0x5600000 + i),
+        .title = "Window " + std::to_string(i),
+        .class_name = "app" + std::to_string(app),
+        .initial_class = "app" + std::to_string(app),
+        .workspace = std::to_string(i % 10 + 1),
+        .pid = static_cast<int>(getpid()),
+    });
+  }
+
+  return clients;
+}
+
+// Uncached executable lookup, as every client scan did before the pid cache
+static std::string read_executable(pid_t pid) {
+  std::string link_path = "/proc/" + std::to_string(pid) + "/exe";
+  char buffer[PATH_MAX];
+  ssize_t len = readlink(link_path.c_str(), buffer, sizeof(buffer) - 1);
+  if (len < 0)
+    return "";
+
+  buffer[len] = '\0';
+  return std::string{buffer};
+}
+
+// Running state of the pinned apps, once by scanning every client per app
+// and reading its executable, as before, and once in the single pass used
+// now. No window runs an app's executable, so the scan visits every client
+// for every app like it did for apps without a window.
+static void bench_running_apps(size_t pinned) {
+  auto apps = make_apps(pinned);
+  ClientSnapshot clients{make_clients(BENCH_CLIENTS)};
+  hyprdock::AppMatcher matcher{apps};
+
+  double per_app = measure([&] {
+    std::vector<bool> running(apps.size(), false);
+    for (size_t i = 0; i < apps.size(); i++) {
+      std::string executable = hyprdock::get_exec_name(apps[i].exec);
+      for (const auto &client : clients.get_clients()) {
+        std::string client_exe = read_executable(client.pid);
+        if (client_exe.empty())
+          continue;
+
+        if (std::filesystem::path{client_exe}.filename() == executable) {
+          running[i] = true;
+          break;
+        }
+      }
+    }
+    sink = sink + running.size();
+  });
+
+  double one_pass =
+      measure([&] { sink = sink + matcher.match(clients).size(); });
+
+  std::println("[BENCH] Running apps, {} pinned x {} clients: per-app scan "
+               "{:.2f} us, one pass {:.2f} us",
+               pinned, BENCH_CLIENTS, per_app, one_pass);
+}
+
+// j/clients reply with every field Hyprland sends, most of them unused
+static std::string make_clients_reply(size_t count) {
+  std::string reply = "[";
+  for (size_t i = 0; i < count; i++) {
+    std::string n = std::to_string(i);
+    std::string app = std::to_string(i % BENCH_CLASSES);
+    if (i > 0)
+      reply += ",";
+    reply += "{\"address\": \"0x" + std::to_string(0x5600000 + i) +
+             "\", \"mapped\": true, \"hidden\": false, "
+             "\"at\": [10, 20], \"size\": [1900, 1040], "
+             "\"workspace\": {\"id\": " +
+             std::to_string(i % 10 + 1) + ", \"name\": \"" +
+             std::to_string(i % 10 + 1) +
+             "\"}, \"floating\": false, \"pseudo\": false, "
+             "\"monitor\": 0, \"class\": \"app" +
+             app + "\", \"title\": \"Window " + n +
+             "\", \"initialClass\": \"app" + app +
+             "\", \"initialTitle\": \"Window " + n +
+             "\", \"pid\": " + std::to_string(100000 + i) +
+             ", \"xwayland\": false, \"pinned\": false, "
+             "\"fullscreen\": 0, \"fullscreenClient\": 0, "
+             "\"grouped\": [], \"tags\": [], \"swallowing\": \"0x0\", "
+             "\"focusHistoryID\": " +
+             n + ", \"inhibitingIdle\": false}";
+  }
+
+  return reply + "]";
+}
+
+// The same fields read from a full DOM, as the commands did before the SAX
+// decoders
+static std::vector<Client> decode_clients_dom(const std::string &reply) {
+  std::vector<Client> clients;
+  json resp = json::parse(reply);
+  for (const auto &client : resp) {
+    if (!client.contains("address") || !client.contains("title") ||
+        !client.contains("class") || !client.contains("workspace") ||
+        !client["workspace"].contains("name") || !client.contains("pid"))
+      continue;
+
+    clients.push_back(Client{
+        .address = client["address"].get<std::string>(),
+        .title = client["title"].get<std::string>(),
+        .class_name = client["class"].get<std::string>(),
+        .initial_class = client.value("initialClass", ""),
+        .workspace = client["workspace"]["name"].get<std::string>(),
+        .pid = client["pid"].get<int>(),
+    });
+  }
+
+  return clients;
+}
+
+static void bench_decode_clients(void) {
+  std::string reply = make_clients_reply(BENCH_CLIENTS);
+
+  double dom = measure([&] { sink = sink + decode_clients_dom(reply).size(); });
+  double sax = measure([&] {
+    auto clients = hyprland::decode::decode_clients(reply);
+    sink = sink + (clients ? clients->size() : 0);
+  });
+
+  std::println("[BENCH] j/clients decode, {} clients ({} KiB): DOM {:.2f} us, "
+               "SAX {:.2f} us",
+               BENCH_CLIENTS, reply.size() / 1024, dom, sax);
+}
+
+int main(void) {
+  for (size_t pinned : BENCH_PINNED)
+    bench_running_apps(pinned);
+  bench_decode_clients();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace hyprdock {
+
+enum class Easing {
+  Linear,
+  EaseOutCubic,
+  EaseInOutCubic,
+};
+
+float apply_easing(Easing easing, float t);
+
+// Float value moving towards a target over monotonic time. The duration
+// covers the full 0 to 1 range, shorter moves take proportionally less time
+// so the speed is the same no matter where a fade gets reversed.
+class Tween {
+public:
+  using Clock = std::chrono::steady_clock;
+  using Seconds = std::chrono::duration<float>;
+
+  void set_target(float target, Seconds duration, Easing easing,
+                  Clock::time_point now);
+  float get_value(Clock::time_point now) const;
+  bool is_active(Clock::time_point now) const;
+
+  inline float get_target(void) const {
+    return this->to;
+  }
+
+private:
+  float from = 0.0f;
+  float to = 0.0f;
+  Clock::time_point start{};
+  Seconds duration{0.0f};
+  Easing easing = Easing::Linear;
+};
+
+// One 0 to 1 fade per dock slot with separate in and out durations
+class Animator {
+public:
+  Animator(void) = default;
+  Animator(size_t count, Tween::Seconds fade_in, Tween::Seconds fade_out,
+           Easing easing = Easing::Linear);
+
+  void set_active(size_t index, bool active, Tween::Clock::time_point now);
+  float get_value(size_t index, Tween::Clock::time_point now) const;
+  // False once every fade has settled, nothing needs to be redrawn then
+  bool is_active(Tween::Clock::time_point now) const;
+
+  // Slots added or removed later keep the fades of every other slot
+  void push(void);
+  void erase(size_t index);
+
+private:
+  std::vector<Tween> tweens;
+  Tween::Seconds fade_in{0.0f};
+  Tween::Seconds fade_out{0.0f};
+  Easing easing = Easing::Linear;
+};
+
+} // namespace hyprdock
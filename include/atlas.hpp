@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <raylib.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cache.hpp"
+#include "utils.hpp"
+
+namespace hyprdock {
+
+// Every app icon, the "?" fallback glyph and a white block for shapes packed
+// into one texture. With the white block set as the shapes texture the whole
+// dock draws without a single texture switch, so rlgl never splits the batch.
+class IconAtlas {
+public:
+  // Needs a GL context, replaces any previously built atlas
+  bool build(const std::vector<DesktopEntry> &apps, int icon_size,
+             IconPixelCache &pixel_cache);
+  void unload(void);
+
+  // Adds a slot after the existing ones. Only its own cell is uploaded, the
+  // texture is replaced by a taller one when no cell is free.
+  bool push(const DesktopEntry &app, IconPixelCache &pixel_cache);
+  // Removes a slot, its cell is reused once no other slot shares the icon
+  void erase(size_t app);
+
+  inline const Texture2D &get_texture(void) const {
+    return this->texture;
+  }
+
+  // Source rectangle of an app, the "?" glyph when its icon failed to load
+  inline Rectangle get_slot(size_t app) const {
+    return this->has_icon(app) ? this->slots[app] : this->unknown;
+  }
+
+  inline bool has_icon(size_t app) const {
+    return app < this->slots.size() && this->slots[app].width > 0;
+  }
+
+  inline Rectangle get_white_rect(void) const {
+    return this->white;
+  }
+
+  // RGBA bytes of the texture including all of its mipmap levels
+  size_t get_memory_size(void) const;
+
+private:
+  struct Cell {
+    size_t index;
+    size_t users;
+  };
+
+  Texture2D texture{};
+  std::vector<Rectangle> slots;
+  // Icon path of every slot, empty when it failed to load
+  std::vector<std::string> slot_icons;
+  Rectangle unknown{};
+  Rectangle white{};
+
+  int icon_size = 0;
+  int columns = 0;
+  int rows = 0;
+  std::unordered_map<std::string, Cell> cells;
+  std::vector<size_t> free_cells;
+  size_t next_cell = 0;
+
+  Rectangle get_cell(size_t cell) const;
+  bool grow(void);
+};
+
+} // namespace hyprdock
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <raylib.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "desktop.hpp"
+
+namespace fs = std::filesystem;
+
+namespace hyprdock {
+
+struct DirStamp {
+  std::string path;
+  // Nanoseconds since the epoch, -1 when the directory does not exist
+  int64_t mtime;
+};
+
+// Desktop index and resolved icon paths kept between runs in
+// $XDG_CACHE_HOME/hyprdock. The cache is thrown away as soon as any of the
+// scanned directories has a different mtime than when it was written.
+class DesktopCache {
+public:
+  DesktopCache(void);
+
+  inline bool is_warm(void) const {
+    return this->warm;
+  }
+
+  // Scans the applications directories when the cache was stale
+  const DesktopIndex &get_index(void);
+  // desired_size is in pixels, the app size times the monitor scale
+  std::string resolve_icon(const std::string &icon_name, int desired_size);
+  // Writes the cache back if anything had to be scanned or resolved
+  void save(void);
+
+private:
+  fs::path path;
+  std::string key;
+  bool warm = false;
+  bool dirty = false;
+  bool index_loaded = false;
+  bool icons_scanned = false;
+
+  DesktopIndex index;
+  std::vector<DirStamp> app_stamps;
+  std::vector<DirStamp> icon_stamps;
+  std::unordered_map<std::string, std::string> icons;
+
+  bool load(void);
+};
+
+// Icons decoded and resampled to the size they are drawn at, kept as raw
+// RGBA in $XDG_CACHE_HOME/hyprdock so startup uploads textures without
+// decoding a single PNG. Entries are keyed by source path, mtime and size.
+class IconPixelCache {
+public:
+  IconPixelCache(void);
+  ~IconPixelCache(void);
+
+  IconPixelCache(const IconPixelCache &) = delete;
+  IconPixelCache &operator=(const IconPixelCache &) = delete;
+
+  // The returned pixels are owned by the cache and live as long as it does
+  std::optional<Image> load_image(const std::string &icon_path, int size);
+  // Writes the cache back if an icon had to be decoded or went unused
+  void save(void);
+
+private:
+  struct PixelIcon {
+    std::string path;
+    int64_t mtime;
+    int size;
+    int width;
+    int height;
+    // Points into the mapped cache file or into decoded
+    const unsigned char *pixels;
+    std::vector<unsigned char> decoded;
+    bool used = false;
+  };
+
+  fs::path path;
+  bool dirty = false;
+  const char *mapping = nullptr;
+  size_t mapping_size = 0;
+  std::unordered_map<std::string, PixelIcon> icons;
+};
+
+fs::path get_cache_dir();
+
+} // namespace hyprdock
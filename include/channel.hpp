@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace hyprdock {
+
+// Lock-free single-producer/single-consumer ring buffer
+template <typename T, size_t Capacity> class Channel {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "Channel capacity must be a power of two");
+
+public:
+  // Producer side, returns false if the channel is full
+  bool push(T value) {
+    size_t head = this->head.load(std::memory_order_relaxed);
+    size_t tail = this->tail.load(std::memory_order_acquire);
+    if (head - tail == Capacity)
+      return false;
+
+    this->slots[head & (Capacity - 1)] = std::move(value);
+    this->head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side
+  std::optional<T> pop(void) {
+    size_t tail = this->tail.load(std::memory_order_relaxed);
+    size_t head = this->head.load(std::memory_order_acquire);
+    if (tail == head)
+      return std::nullopt;
+
+    T value = std::move(this->slots[tail & (Capacity - 1)]);
+    this->tail.store(tail + 1, std::memory_order_release);
+    return value;
+  }
+
+private:
+  std::array<T, Capacity> slots{};
+  alignas(64) std::atomic<size_t> head{0};
+  alignas(64) std::atomic<size_t> tail{0};
+};
+
+// Lock-free single slot holding the most recent value. A new value replaces
+// one the consumer has not taken yet, so the latest state is never dropped.
+// Values live on the heap and change hands with one atomic pointer exchange.
+template <typename T> class Latest {
+  static_assert(std::atomic<T *>::is_always_lock_free);
+
+public:
+  Latest(void) = default;
+  Latest(const Latest &) = delete;
+  Latest &operator=(const Latest &) = delete;
+
+  ~Latest(void) {
+    delete this->slot.load(std::memory_order_acquire);
+  }
+
+  // Producer side
+  void store(T value) {
+    T *previous = this->slot.exchange(new T(std::move(value)),
+                                      std::memory_order_acq_rel);
+    delete previous;
+  }
+
+  // Consumer side
+  std::optional<T> take(void) {
+    std::unique_ptr<T> value{
+        this->slot.exchange(nullptr, std::memory_order_acq_rel)};
+    if (!value)
+      return std::nullopt;
+
+    return std::move(*value);
+  }
+
+private:
+  std::atomic<T *> slot{nullptr};
+};
+
+} // namespace hyprdock
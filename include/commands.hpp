@@ -1,33 +1,80 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "ipc.hpp"
+#include "utils.hpp"
+
 struct Monitor {
   int id;
   int width;
   int height;
+  float scale = 1.0f;
+};
+
+struct Client {
+  std::string address;
+  std::string title;
+  std::string class_name;
+  std::string initial_class;
+  std::string workspace;
+  int pid;
+};
+
+// Parsed j/clients reply indexed by the fields the commands look clients up by
+class ClientSnapshot {
+public:
+  ClientSnapshot(void) = default;
+  explicit ClientSnapshot(std::vector<Client> clients);
+
+  const Client *find_by_address(const std::string &address) const;
+  const Client *find_by_title(const std::string &title) const;
+  const Client *find_by_class(const std::string &class_name) const;
+  const Client *find_by_pid(int pid) const;
+
+  // Apply a movewindow event without refetching the client list
+  void move_client(const std::string &address, const std::string &workspace);
+
+  inline const std::vector<Client> &get_clients(void) const {
+    return this->clients;
+  }
+
+private:
+  std::vector<Client> clients;
+  std::unordered_map<std::string, size_t> by_address;
+  std::unordered_map<std::string, size_t> by_title;
+  std::unordered_map<std::string, size_t> by_class;
+  std::unordered_map<int, size_t> by_pid;
 };
 
 namespace hyprland::command {
 
 std::vector<Monitor> get_monitors(const std::string &sock_path);
 std::pair<int, int> get_mouse_position(const std::string &sock_path);
-std::string hide_window(const std::string &title, const std::string &sock_path);
+ClientSnapshot get_clients(const std::string &sock_path);
+std::string hide_window(const std::string &title, const ClientSnapshot &clients,
+                        hyprland::IPC::Batch &batch);
 std::string move_window_to_workspace(const std::string &title,
                                      const std::string &workspace,
-                                     const std::string &sock_path);
+                                     const ClientSnapshot &clients,
+                                     hyprland::IPC::Batch &batch);
+std::string move_window_to_workspace_silent(const std::string &title,
+                                            const std::string &workspace,
+                                            const ClientSnapshot &clients,
+                                            hyprland::IPC::Batch &batch);
 void move_mouse(const std::pair<int, int> mouse_pos,
-                const std::string &sock_path);
+                hyprland::IPC::Batch &batch);
 std::string get_active_workspace(const std::string &sock_path);
 bool is_empty_workspace(const std::string &uuid, const std::string &workspace,
                         const std::string &sock_path);
-std::string get_window_from_proc(const std::string &proc,
-                                 const std::string &sock_path);
-void focus_window(const std::string &address, const std::string &sock_path);
-void set_plain_window(const std::string &uuid, const std::string &sock_path);
+// Commands containing ';' are sent outside the batch by Batch::send
+void exec(const std::string &command, hyprland::IPC::Batch &batch);
+void focus_window(const std::string &address, hyprland::IPC::Batch &batch);
+void set_plain_window(const std::string &uuid, hyprland::IPC::Batch &batch);
 void set_unmoveable_window(const std::string &uuid,
-                           const std::string &sock_path);
+                           hyprland::IPC::Batch &batch);
 
 } // namespace hyprland::command
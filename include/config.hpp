@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 
+#include "cache.hpp"
 #include "utils.hpp"
 
 struct App {
@@ -12,9 +13,20 @@ struct App {
   std::string run;
 };
 
+enum class LaunchBackend {
+  // posix_spawn from the dock, children are reaped by the IPC worker
+  Spawn,
+  // Hyprland's exec dispatcher, apps become children of the compositor
+  Hyprland,
+};
+
 struct Config {
   int monitor;
   int wait_time;
+  bool edge_trigger;
+  LaunchBackend launch_backend;
+  // Also show running apps that are not pinned
+  bool taskbar;
 
   int dock_padding;
   int dock_margin;
@@ -26,8 +38,17 @@ struct Config {
   std::vector<DesktopEntry> applications;
 };
 
+// Command line flags
+struct Options {
+  bool stats = false;
+  bool timing = false;
+  bool draw_calls = false;
+};
+
 namespace hyprdock {
 
-Config load_config();
+Options parse_options(int argc, char **argv);
+// Icons of the apps are left unresolved, their size depends on the monitor
+Config load_config(const Options &options, DesktopCache &desktop_cache);
 
 } // namespace hyprdock
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <expected>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "commands.hpp"
+
+// Field-selective decoders for Hyprland IPC replies, only the fields the dock
+// uses are extracted and no JSON DOM is built
+namespace hyprland::decode {
+
+std::expected<std::vector<Monitor>, std::string>
+decode_monitors(std::string_view reply);
+std::expected<std::pair<int, int>, std::string>
+decode_cursor_pos(std::string_view reply);
+std::expected<std::string, std::string>
+decode_workspace_name(std::string_view reply);
+std::expected<std::vector<Client>, std::string>
+decode_clients(std::string_view reply);
+
+} // namespace hyprland::decode
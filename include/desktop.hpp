@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+namespace hyprdock {
+
+// Every desktop entry visible to the user, indexed by lowercased Name and
+// desktop-file ID. Built in a single pass over the applications directories.
+class DesktopIndex {
+public:
+  DesktopIndex(void) = default;
+  // Directories in XDG precedence order, earlier ones shadow later ones
+  explicit DesktopIndex(const std::vector<fs::path> &app_dirs);
+  // Rebuilds the lookup tables over entries that were already scanned
+  explicit DesktopIndex(std::vector<DesktopEntry> entries);
+
+  std::optional<DesktopEntry> find(const std::string &name) const;
+
+  inline size_t size(void) const {
+    return this->entries.size();
+  }
+
+  inline const std::vector<DesktopEntry> &get_entries(void) const {
+    return this->entries;
+  }
+
+  // Every directory the scan listed, their mtimes tell when it is stale
+  inline const std::vector<fs::path> &get_scanned_dirs(void) const {
+    return this->scanned_dirs;
+  }
+
+private:
+  std::vector<DesktopEntry> entries;
+  std::unordered_map<std::string, size_t> by_name;
+  std::unordered_map<std::string, size_t> by_id;
+  std::vector<fs::path> scanned_dirs;
+
+  void add(const std::string &id, const fs::path &path);
+  void insert(DesktopEntry entry);
+};
+
+std::vector<fs::path> get_application_dirs();
+DesktopIndex build_desktop_index();
+
+} // namespace hyprdock
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hyprland::events {
+
+enum class EventType {
+  Workspace,
+  OpenWindow,
+  CloseWindow,
+  MoveWindow,
+  ActiveWindow,
+};
+
+struct Event {
+  EventType type;
+  std::vector<std::string> args;
+};
+
+std::optional<Event> parse_event(std::string_view line);
+
+// Non-blocking reader for the Hyprland event socket (.socket2.sock)
+class Listener {
+public:
+  Listener(void) = default;
+  ~Listener(void);
+
+  Listener(const Listener &) = delete;
+  Listener &operator=(const Listener &) = delete;
+
+  bool connect(const std::string &sock_path);
+  void disconnect(void);
+  std::vector<Event> read_events(void);
+
+  inline bool is_connected(void) const {
+    return this->fd >= 0;
+  }
+
+  inline int get_fd(void) const {
+    return this->fd;
+  }
+
+private:
+  int fd = -1;
+  std::string pending;
+};
+
+} // namespace hyprland::events
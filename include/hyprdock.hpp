@@ -1,17 +1,39 @@
 #pragma once
 
+#include <algorithm>
 #include <chrono>
+#include <memory>
 #include <raylib.h>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "animation.hpp"
+#include "atlas.hpp"
+#include "cache.hpp"
 #include "commands.hpp"
 #include "config.hpp"
+#include "worker.hpp"
+
+// Height of the strip left at the screen edge while the dock is hidden
+#define TRIGGER_HEIGHT 2
+
+// Hover overlay fade durations in seconds
+#define FADE_IN_TIME 0.3f
+#define FADE_OUT_TIME 0.2f
+
+// Seconds between snapshot checks in builds that cannot interrupt raylib's
+// event waiting
+#define EVENT_POLL_INTERVAL 0.1
 
 namespace hyprdock {
 
+// Lets EndDrawing sleep until input arrives or a snapshot is published
+void enable_event_waiting(void);
+// Sleeps until input arrives or a snapshot is published
+void wait_for_events(void);
+
 struct State {
+  Options options;
   Config config;
   Monitor monitor;
 
@@ -20,22 +42,33 @@ struct State {
   int window_x;
   int window_y;
   int fps;
+  // Pixel size of an icon on the monitor
+  int icon_size;
 
   int clicked_app = -1;
+  int hovered_app = -1;
 
   double prevoius_time;
 
   Rectangle hover_area;
 
-  std::string active_workspace;
   std::string sock_path;
   std::string uuid;
 
-  std::vector<unsigned char> animations;
+  Animator animations;
   std::vector<bool> active_cache;
-  std::unordered_map<std::string, Texture2D> app_icons;
+  std::vector<bool> launching;
+  // Unpinned running apps, their slots follow the pinned ones
+  std::vector<DesktopEntry> taskbar_apps;
+  std::shared_ptr<const std::vector<DesktopEntry>> taskbar;
+  IconPixelCache pixel_cache;
+  IconAtlas atlas;
+  // Background, icons and running dots, redrawn only when one changes
+  RenderTexture2D static_layer{};
+  bool layer_dirty = true;
+
+  IpcWorker worker;
 
-  std::chrono::time_point<std::chrono::steady_clock> last_command_time;
   std::chrono::time_point<std::chrono::steady_clock> start_wait_time;
 
   std::pair<int, int> wait_mouse_pos;
@@ -44,15 +77,55 @@ struct State {
   bool is_minimized;
   bool first_frame;
   bool waiting;
+  bool dirty = true;
 
-  const std::chrono::milliseconds command_interval{100};
   std::chrono::milliseconds wait_interval;
 
   bool error = false;
 
-  State(void);
+  State(const Options &options);
 
   void unload(void);
+  void apply_snapshot(IpcSnapshot snapshot);
+  void update_taskbar(const std::vector<DesktopEntry> &apps);
+  void update_layout(void);
+  void relayout(void);
+  void reveal(void);
+  void hide(void);
+  void load_static_layer(void);
+  void render_static_layer(void);
+  void draw_icon(int index);
+
+  // Pixel density of the static layer, the same as the icons'
+  inline float get_layer_scale(void) const {
+    return std::max(this->monitor.scale, 1.0f);
+  }
+
+  inline size_t get_app_count(void) const {
+    return this->config.applications.size() + this->taskbar_apps.size();
+  }
+
+  inline const DesktopEntry &get_app(size_t index) const {
+    size_t pinned = this->config.applications.size();
+    return index < pinned ? this->config.applications[index]
+                          : this->taskbar_apps[index - pinned];
+  }
+
+  inline Rectangle get_app_rect(int index) {
+    return Rectangle{
+        static_cast<float>(this->config.dock_padding +
+                           index * (this->config.app_size +
+                                    this->config.app_padding)),
+        static_cast<float>(this->config.dock_padding),
+        static_cast<float>(this->config.app_size),
+        static_cast<float>(this->config.app_size),
+    };
+  }
+
+  inline bool is_launching(void) {
+    return std::find(this->launching.begin(), this->launching.end(), true) !=
+           this->launching.end();
+  }
 
   inline bool is_valid_mouse_pos(void) {
     return this->mouse_pos.first >= 0 && this->mouse_pos.second >= 0;
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace hyprdock {
+
+enum class IconDirType {
+  Fixed,
+  Scalable,
+  Threshold,
+};
+
+// One subdirectory of an icon theme as described by its index.theme
+struct IconDirectory {
+  std::string path;
+  IconDirType type = IconDirType::Threshold;
+  int size = 0;
+  int scale = 1;
+  int min_size = 0;
+  int max_size = 0;
+  int threshold = 2;
+
+  bool matches_size(int icon_size, int icon_scale) const;
+  int size_distance(int icon_size, int icon_scale) const;
+};
+
+struct IconCandidate {
+  size_t directory;
+  fs::path path;
+};
+
+struct IconTheme {
+  std::string name;
+  std::vector<std::string> inherits;
+  std::vector<IconDirectory> directories;
+  std::unordered_map<std::string, std::vector<IconCandidate>> icons;
+};
+
+// In-memory table of every icon in a theme chain, built once by listing the
+// theme directories so a lookup never touches the filesystem
+class IconLookup {
+public:
+  IconLookup(void) = default;
+  IconLookup(const std::string &theme_name,
+             const std::vector<fs::path> &base_dirs);
+
+  std::string find(const std::string &icon_name, int size,
+                   int scale = 1) const;
+
+  // Every directory that was listed, their mtimes tell when it is stale
+  inline const std::vector<fs::path> &get_scanned_dirs(void) const {
+    return this->scanned_dirs;
+  }
+
+private:
+  std::vector<IconTheme> chain;
+  std::unordered_map<std::string, fs::path> pixmaps;
+  std::vector<fs::path> scanned_dirs;
+
+  bool load_theme(const std::string &theme_name,
+                  const std::vector<fs::path> &base_dirs);
+};
+
+std::vector<fs::path> get_icon_base_dirs();
+std::string get_user_icon_theme();
+const IconLookup &get_icon_lookup();
+
+} // namespace hyprdock
@@ -3,13 +3,37 @@
 #include <expected>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace hyprland::IPC {
 
 std::optional<std::string> get_runtime_dir();
 std::optional<std::string> get_instance_signature();
 std::optional<std::string> get_socket_path();
-std::expected<std::string, std::string>
+std::optional<std::string> get_event_socket_path();
+// The returned view points into a per-thread buffer that is reused by the next
+// command sent from the same thread
+std::expected<std::string_view, std::string>
 send_command(const std::string &command, const std::string &sock_path);
 
+// Collects dispatches and keywords and sends them as a single [[BATCH]]
+// request. Commands containing ';' are sent on their own, in order, since
+// Hyprland would split them apart.
+class Batch {
+public:
+  Batch &dispatch(const std::string &args);
+  Batch &keyword(const std::string &args);
+  // Stops at the first failed request, otherwise returns the last reply
+  std::expected<std::string_view, std::string>
+  send(const std::string &sock_path);
+
+  inline bool empty(void) const {
+    return this->commands.empty();
+  }
+
+private:
+  std::vector<std::string> commands;
+};
+
 } // namespace hyprland::IPC
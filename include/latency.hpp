@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <sys/types.h>
+#include <vector>
+
+#include "commands.hpp"
+#include "utils.hpp"
+
+namespace hyprdock {
+
+// Blocks SIGUSR1, which asks the IPC worker to print the launch latencies.
+// Like SIGCHLD it has to be blocked before any thread is started.
+void block_report_signal(void);
+
+// Time from launching an app until its first window maps, per dock slot
+class LaunchTracker {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  void resize(size_t apps);
+  // pid is unknown when the compositor started the app
+  void start(size_t app, std::optional<pid_t> pid, Clock::time_point now);
+  // Matches pending launches to a client with the launched pid, or to the
+  // app's first window. True when a launch completed.
+  bool match(const ClientSnapshot &clients, const std::vector<bool> &running,
+             Clock::time_point now);
+  // Gives up on launches that never opened a window, true if any did
+  bool expire(Clock::time_point now);
+
+  std::vector<bool> get_pending(void) const;
+  std::optional<Clock::time_point> next_expiry(void) const;
+  bool has_samples(void) const;
+  void print(const std::vector<DesktopEntry> &apps) const;
+
+private:
+  struct Launch {
+    size_t app;
+    std::optional<pid_t> pid;
+    Clock::time_point start;
+  };
+
+  std::vector<Launch> pending;
+  // Completed launch latencies in milliseconds
+  std::vector<std::vector<double>> samples;
+  size_t expired = 0;
+
+  const std::chrono::seconds timeout{30};
+};
+
+} // namespace hyprdock
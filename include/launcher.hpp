@@ -0,0 +1,49 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#include "utils.hpp"
+
+namespace hyprdock {
+
+// Blocks SIGCHLD in the calling thread. Threads created afterwards inherit
+// the mask, so child exits are only ever consumed through the reaper.
+void block_child_signal(void);
+
+// Argument vector of an Exec key with quoting resolved and field codes
+// expanded, no files or URLs are ever passed from the dock
+std::vector<std::string> expand_exec(const DesktopEntry &app);
+// Basename of the program an Exec key runs
+std::string get_exec_name(const std::string &exec);
+// Arguments joined into one `sh -c` command, quoted where needed
+std::string join_shell_command(const std::vector<std::string> &args);
+
+// Starts apps with posix_spawn and reaps them through a signalfd so they
+// never linger as zombies
+class Launcher {
+public:
+  Launcher(void) = default;
+  ~Launcher(void);
+
+  Launcher(const Launcher &) = delete;
+  Launcher &operator=(const Launcher &) = delete;
+
+  bool start(void);
+  void stop(void);
+
+  std::optional<pid_t> spawn(const DesktopEntry &app);
+  // Collects every exited child, call whenever the fd is readable
+  void reap(void);
+
+  inline int get_fd(void) const {
+    return this->signal_fd;
+  }
+
+private:
+  int signal_fd = -1;
+};
+
+} // namespace hyprdock
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "commands.hpp"
+#include "utils.hpp"
+
+namespace hyprdock {
+
+// Maps Hyprland clients to dock slots. A client's class and initial class
+// are looked up against every app's StartupWMClass, desktop-file ID and
+// executable name. /proc is only read for clients none of those match.
+class AppMatcher {
+public:
+  AppMatcher(void) = default;
+  explicit AppMatcher(const std::vector<DesktopEntry> &apps);
+
+  // First window of every app, nullptr for apps without one. Clients that
+  // belong to no app are added to unmatched when given. The pointers are
+  // only valid as long as the snapshot is.
+  std::vector<const Client *>
+  match(const ClientSnapshot &clients,
+        std::vector<const Client *> *unmatched = nullptr);
+  std::optional<size_t> find(const Client &client);
+  // Drops cached executables of clients that are gone
+  void prune(const std::unordered_set<pid_t> &live_pids);
+
+private:
+  size_t app_count = 0;
+  std::unordered_map<std::string, size_t> by_class;
+  std::unordered_map<std::string, size_t> by_executable;
+
+  std::optional<size_t> find_by_class(const Client &client) const;
+  std::optional<size_t> find_by_proc(pid_t pid) const;
+};
+
+} // namespace hyprdock
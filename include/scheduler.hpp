@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace hyprdock {
+
+enum class Query : size_t {
+  Cursor,
+  Workspace,
+  Clients,
+  Count,
+};
+
+struct PollRate {
+  std::chrono::milliseconds min{100};
+  std::chrono::milliseconds max{100};
+  std::chrono::milliseconds current{100};
+  std::chrono::steady_clock::time_point last_poll{};
+  std::chrono::steady_clock::time_point next_due{};
+  bool enabled = false;
+  uint64_t polls = 0;
+};
+
+// Gives every IPC query its own polling interval which backs off
+// exponentially up to a limit and snaps back to the minimum on demand
+class PollScheduler {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  void configure(Query query, std::chrono::milliseconds min,
+                 std::chrono::milliseconds max);
+  // Enabling a query makes it due right away
+  void set_enabled(Query query, bool enabled);
+
+  // Both reschedule the next poll from the previous one with the new
+  // interval, so they can be called after mark_polled
+  void reset(Query query);
+  void back_off(Query query, std::chrono::milliseconds limit);
+
+  bool is_due(Query query, Clock::time_point now) const;
+  void mark_polled(Query query, Clock::time_point now);
+  std::optional<Clock::time_point> next_deadline(void) const;
+
+  // Number of polls since the previous call
+  uint64_t take_polls(Query query);
+
+  inline const PollRate &get_rate(Query query) const {
+    return this->rates[static_cast<size_t>(query)];
+  }
+
+private:
+  std::array<PollRate, static_cast<size_t>(Query::Count)> rates{};
+
+  inline PollRate &rate(Query query) {
+    return this->rates[static_cast<size_t>(query)];
+  }
+};
+
+} // namespace hyprdock
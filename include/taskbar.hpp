@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "cache.hpp"
+#include "commands.hpp"
+#include "matcher.hpp"
+#include "utils.hpp"
+
+namespace hyprdock {
+
+// Running apps that are not pinned, in the order they were first seen.
+// Every update is diffed against the previous one, only apps that showed up
+// get a desktop entry and icon resolved and the list is only replaced when
+// an app was added or removed.
+class Taskbar {
+public:
+  // Windows titled uuid belong to the dock itself and are never listed
+  void start(const std::string &uuid, int icon_size,
+             DesktopCache desktop_cache);
+  void stop(void);
+
+  // True when an app was added or removed
+  bool update(const ClientSnapshot &clients,
+              const std::vector<const Client *> &unmatched);
+
+  // Shared with published snapshots, never modified once replaced
+  inline std::shared_ptr<const std::vector<DesktopEntry>>
+  get_apps(void) const {
+    return this->apps;
+  }
+
+  inline size_t size(void) const {
+    return this->apps ? this->apps->size() : 0;
+  }
+
+  // First window of the app with the given ID, if it still has one
+  const Client *find_window(const std::string &id) const;
+
+private:
+  std::string uuid;
+  int icon_size = 0;
+  std::optional<DesktopCache> desktop_cache;
+  // Maps clients to every known desktop entry
+  AppMatcher matcher;
+
+  std::shared_ptr<const std::vector<DesktopEntry>> apps;
+  // First window of every app, points into the last updated snapshot
+  std::vector<const Client *> windows;
+
+  DesktopEntry resolve(const Client &client, const std::string &id,
+                       std::optional<size_t> entry);
+};
+
+} // namespace hyprdock
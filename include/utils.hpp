@@ -4,13 +4,20 @@
 #include <optional>
 #include <string>
 #include <sys/types.h>
+#include <unordered_set>
 #include <vector>
 
 struct DesktopEntry {
+  std::string id;
+  // Path of the .desktop file the entry was read from
+  std::string path;
   std::string name;
   std::string comment;
+  std::string icon_name;
+  // Resolved icon path, only filled in for apps shown on the dock
   std::string icon;
   std::string exec;
+  std::string startup_wm_class;
   std::string type;
   bool no_display = false;
   bool hidden = false;
@@ -21,14 +28,12 @@ namespace fs = std::filesystem;
 namespace hyprdock {
 
 std::string trim(const std::string &str);
+std::string to_lower(std::string str);
 std::vector<fs::path> get_xdg_data_dirs();
-std::string get_name_from_pid(const std::string &pid);
+std::string get_name_from_pid(pid_t pid);
+void prune_pid_cache(const std::unordered_set<pid_t> &live_pids);
 std::string generate_id();
-std::string resolve_app_icon(const std::string &icon_name,
-                             int desired_size = 48);
+std::string resolve_app_icon(const std::string &icon_name, int desired_size);
 std::optional<DesktopEntry> parse_desktop_file(const fs::path &path);
-std::optional<DesktopEntry> get_entry_for_name(const std::string &name);
-std::string get_first_token(const std::string &str);
-void run_app(const DesktopEntry &app);
 
 } // namespace hyprdock
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <raylib.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cache.hpp"
+#include "channel.hpp"
+#include "commands.hpp"
+#include "config.hpp"
+#include "events.hpp"
+#include "latency.hpp"
+#include "launcher.hpp"
+#include "matcher.hpp"
+#include "scheduler.hpp"
+#include "taskbar.hpp"
+#include "utils.hpp"
+
+// Cursor distance from the hover area below which polling stays fast
+#define NEAR_DISTANCE 150
+
+namespace hyprdock {
+
+// Compositor state published by the IPC worker, never modified once sent
+struct IpcSnapshot {
+  std::pair<int, int> mouse_pos;
+  std::string active_workspace;
+  std::vector<bool> running;
+  // Launched from the dock and still waiting for their first window
+  std::vector<bool> launching;
+  // Unpinned running apps shown after the pinned ones, the same list is
+  // shared by every snapshot until an app is added or removed
+  std::shared_ptr<const std::vector<DesktopEntry>> taskbar;
+};
+
+enum class RequestType {
+  Reveal,
+  Hide,
+  Activate,
+  Resize,
+};
+
+struct Request {
+  RequestType type;
+  std::pair<int, int> mouse_pos;
+  size_t app = 0;
+  // Taskbar slots shift as apps come and go, so they are looked up by ID
+  std::string app_id{};
+  // Hover area of the dock after it was resized
+  Rectangle hover_area{};
+};
+
+struct WorkerOptions {
+  std::string sock_path;
+  std::string uuid;
+  std::vector<DesktopEntry> apps;
+  Rectangle hover_area;
+  bool visible;
+  // Hidden dock shrinks to a strip whose pointer events drive the reveal, so
+  // the cursor is only polled while the dock is shown
+  bool edge_trigger;
+  LaunchBackend launch_backend;
+  bool taskbar;
+  // Pixel size taskbar icons are resolved at
+  int icon_size;
+  // Desktop index loaded at startup, taskbar apps are looked up in it
+  std::optional<DesktopCache> desktop_cache{};
+  bool print_stats;
+  // Called from the worker thread after a snapshot was published
+  std::function<void(void)> on_publish{};
+};
+
+// Wakeup counters of both threads, reported with --stats
+struct WakeupStats {
+  std::atomic<uint64_t> worker{0};
+  std::atomic<uint64_t> render{0};
+};
+
+// Owns every Hyprland IPC call made after startup so the render loop never
+// blocks on the compositor socket
+class IpcWorker {
+public:
+  WakeupStats stats;
+
+  IpcWorker(void) = default;
+  ~IpcWorker(void);
+
+  IpcWorker(const IpcWorker &) = delete;
+  IpcWorker &operator=(const IpcWorker &) = delete;
+
+  bool start(WorkerOptions options);
+  void stop(void);
+
+  // Render thread side
+  bool send(const Request &request);
+  std::optional<IpcSnapshot> poll_snapshot(void);
+
+private:
+  std::thread thread;
+  std::atomic<bool> running{false};
+  int wake_fd = -1;
+  int timer_fd = -1;
+
+  // Only the most recent state matters to the render thread
+  Latest<IpcSnapshot> snapshots;
+  Channel<Request, 64> requests;
+
+  // Only touched by the worker thread once started
+  WorkerOptions options;
+
+  hyprland::events::Listener events;
+  Launcher launcher;
+  LaunchTracker launches;
+  int report_fd = -1;
+  bool launches_dirty = false;
+  ClientSnapshot clients;
+  AppMatcher matcher;
+  // First window of every app, points into clients
+  std::vector<const Client *> app_windows;
+  Taskbar taskbar;
+  std::string active_workspace;
+  std::pair<int, int> mouse_pos{-1, -1};
+  std::vector<bool> active_cache;
+  bool clients_dirty = true;
+  bool was_hovering = false;
+
+  PollScheduler scheduler;
+
+  const std::chrono::milliseconds cursor_interval{100};
+  const std::chrono::milliseconds cursor_limit{800};
+  const std::chrono::milliseconds fallback_interval{1000};
+  const std::chrono::seconds stats_interval{10};
+
+  void run(void);
+  bool handle_events(void);
+  bool refresh_clients(void);
+  bool handle_request(const Request &request);
+  void publish(void);
+  bool run_due_queries(void);
+  void update_cursor_polling(void);
+  void arm_poll_timer(void);
+  void print_stats(std::chrono::steady_clock::duration elapsed);
+
+  // Distance in pixels from the cursor to the hover area, 0 when inside
+  inline float get_hover_distance(void) const {
+    const Rectangle &area = this->options.hover_area;
+    float x = static_cast<float>(this->mouse_pos.first);
+    float y = static_cast<float>(this->mouse_pos.second);
+    float dx = std::max({area.x - x, 0.0f, x - (area.x + area.width)});
+    float dy = std::max({area.y - y, 0.0f, y - (area.y + area.height)});
+    return std::max(dx, dy);
+  }
+};
+
+} // namespace hyprdock
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+
+#include "animation.hpp"
+
+namespace hyprdock {
+
+float apply_easing(Easing easing, float t) {
+  switch (easing) {
+  case Easing::Linear:
+    return t;
+  case Easing::EaseOutCubic:
+    return 1.0f - std::pow(1.0f - t, 3.0f);
+  case Easing::EaseInOutCubic:
+    return t < 0.5f ? 4.0f * t * t * t
+                    : 1.0f - std::pow(-2.0f * t + 2.0f, 3.0f) / 2.0f;
+  }
+
+  return t;
+}
+
+void Tween::set_target(float target, Seconds duration, Easing easing,
+                       Clock::time_point now) {
+  if (target == this->to)
+    return;
+
+  this->from = this->get_value(now);
+  this->to = target;
+  this->start = now;
+  this->duration = duration * std::abs(this->to - this->from);
+  this->easing = easing;
+}
+
+float Tween::get_value(Clock::time_point now) const {
+  if (this->duration.count() <= 0.0f)
+    return this->to;
+
+  float t = std::clamp(
+      Seconds{now - this->start}.count() / this->duration.count(), 0.0f, 1.0f);
+  return this->from + (this->to - this->from) * apply_easing(this->easing, t);
+}
+
+bool Tween::is_active(Clock::time_point now) const {
+  return now < this->start + std::chrono::duration_cast<Clock::duration>(
+                                 this->duration);
+}
+
+Animator::Animator(size_t count, Tween::Seconds fade_in,
+                   Tween::Seconds fade_out, Easing easing)
+    : tweens(count), fade_in(fade_in), fade_out(fade_out), easing(easing) {
+}
+
+void Animator::set_active(size_t index, bool active,
+                          Tween::Clock::time_point now) {
+  this->tweens[index].set_target(active ? 1.0f : 0.0f,
+                                 active ? this->fade_in : this->fade_out,
+                                 this->easing, now);
+}
+
+float Animator::get_value(size_t index, Tween::Clock::time_point now) const {
+  return this->tweens[index].get_value(now);
+}
+
+bool Animator::is_active(Tween::Clock::time_point now) const {
+  return std::any_of(
+      this->tweens.begin(), this->tweens.end(),
+      [now](const Tween &tween) { return tween.is_active(now); });
+}
+
+void Animator::push(void) {
+  this->tweens.emplace_back();
+}
+
+void Animator::erase(size_t index) {
+  if (index < this->tweens.size())
+    this->tweens.erase(this->tweens.begin() + index);
+}
+
+} // namespace hyprdock
@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <print>
+#include <raylib.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "atlas.hpp"
+#include "cache.hpp"
+#include "utils.hpp"
+
+// Transparent border around every cell so filtering and the smaller mipmap
+// levels do not bleed neighbouring icons into each other
+#define ATLAS_GUTTER 2
+
+namespace hyprdock {
+
+// Copies an RGBA8 image into the atlas, clipped to the destination cell
+static void blit(Image &atlas, const Image &image, int x, int y, int width,
+                 int height) {
+  int rows = std::min(image.height, height);
+  int columns = std::min(image.width, width);
+  auto *dst = static_cast<unsigned char *>(atlas.data);
+  const auto *src = static_cast<const unsigned char *>(image.data);
+
+  for (int row = 0; row < rows; row++)
+    std::memcpy(dst + (static_cast<size_t>(y + row) * atlas.width + x) * 4,
+                src + static_cast<size_t>(row) * image.width * 4,
+                static_cast<size_t>(columns) * 4);
+}
+
+bool IconAtlas::build(const std::vector<DesktopEntry> &apps, int icon_size,
+                      IconPixelCache &pixel_cache) {
+  this->unload();
+
+  // Apps sharing an icon share a cell
+  std::vector<Image> images;
+  std::vector<std::optional<size_t>> app_cells;
+  for (const auto &app : apps) {
+    auto it = this->cells.find(app.icon);
+    if (it != this->cells.end()) {
+      it->second.users++;
+      app_cells.push_back(it->second.index);
+      this->slot_icons.push_back(app.icon);
+      continue;
+    }
+
+    auto image = pixel_cache.load_image(app.icon, icon_size);
+    if (!image) {
+      std::println("[WARNING] Failed to load icon for {} from {}", app.name,
+                   app.icon);
+      app_cells.push_back(std::nullopt);
+      this->slot_icons.emplace_back();
+      continue;
+    }
+
+    this->cells.emplace(app.icon, Cell{images.size(), 1});
+    app_cells.push_back(images.size());
+    this->slot_icons.push_back(app.icon);
+    images.push_back(*image);
+  }
+
+  // Icons first, then the "?" glyph and the white block, on a square grid
+  size_t cell_count = images.size() + 2;
+  this->icon_size = icon_size;
+  this->columns = static_cast<int>(std::ceil(std::sqrt(cell_count)));
+  this->rows = static_cast<int>((cell_count + this->columns - 1) /
+                                this->columns);
+  this->next_cell = cell_count;
+  int cell_size = icon_size + ATLAS_GUTTER * 2;
+
+  Image atlas = GenImageColor(this->columns * cell_size,
+                              this->rows * cell_size, BLANK);
+  ImageFormat(&atlas, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+  for (size_t i = 0; i < images.size(); i++) {
+    Rectangle cell = this->get_cell(i);
+    blit(atlas, images[i], static_cast<int>(cell.x), static_cast<int>(cell.y),
+         icon_size, icon_size);
+  }
+
+  this->unknown = this->get_cell(images.size());
+  int font_size = icon_size / 2;
+  Image glyph = ImageText("?", font_size, LIGHTGRAY);
+  ImageFormat(&glyph, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+  int glyph_x = std::max(icon_size - glyph.width, 0) / 2;
+  int glyph_y = std::max(icon_size - font_size, 0) / 2;
+  blit(atlas, glyph, static_cast<int>(this->unknown.x) + glyph_x,
+       static_cast<int>(this->unknown.y) + glyph_y, icon_size - glyph_x,
+       icon_size - glyph_y);
+  UnloadImage(glyph);
+
+  // Only the inside of the white block is sampled, its edges blend with the
+  // gutter in the smaller mipmap levels
+  Rectangle white_cell = this->get_cell(images.size() + 1);
+  Image white_image = GenImageColor(icon_size, icon_size, WHITE);
+  ImageFormat(&white_image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+  blit(atlas, white_image, static_cast<int>(white_cell.x),
+       static_cast<int>(white_cell.y), icon_size, icon_size);
+  UnloadImage(white_image);
+
+  float inset = std::min(ATLAS_GUTTER * 2.0f, icon_size / 4.0f);
+  this->white = Rectangle{
+      white_cell.x + inset,
+      white_cell.y + inset,
+      white_cell.width - inset * 2,
+      white_cell.height - inset * 2,
+  };
+
+  this->texture = LoadTextureFromImage(atlas);
+  UnloadImage(atlas);
+  if (this->texture.id == 0) {
+    std::println(std::cerr, "[ERROR] Failed to upload icon atlas");
+    return false;
+  }
+
+  GenTextureMipmaps(&this->texture);
+  SetTextureFilter(this->texture, TEXTURE_FILTER_TRILINEAR);
+
+  for (const auto &cell : app_cells)
+    this->slots.push_back(cell ? this->get_cell(*cell) : Rectangle{});
+
+  return true;
+}
+
+void IconAtlas::unload(void) {
+  if (this->texture.id != 0)
+    UnloadTexture(this->texture);
+
+  this->texture = Texture2D{};
+  this->slots.clear();
+  this->slot_icons.clear();
+  this->cells.clear();
+  this->free_cells.clear();
+  this->next_cell = 0;
+}
+
+bool IconAtlas::push(const DesktopEntry &app, IconPixelCache &pixel_cache) {
+  // Failed slots still take their place so later slots keep their index
+  auto push_unknown = [this] {
+    this->slots.push_back(Rectangle{});
+    this->slot_icons.emplace_back();
+  };
+
+  if (this->texture.id == 0) {
+    push_unknown();
+    return false;
+  }
+
+  auto it = this->cells.find(app.icon);
+  if (it != this->cells.end()) {
+    it->second.users++;
+    this->slots.push_back(this->get_cell(it->second.index));
+    this->slot_icons.push_back(app.icon);
+    return true;
+  }
+
+  auto image = pixel_cache.load_image(app.icon, this->icon_size);
+  if (!image) {
+    std::println("[WARNING] Failed to load icon for {} from {}", app.name,
+                 app.icon);
+    push_unknown();
+    return true;
+  }
+
+  size_t cell;
+  if (!this->free_cells.empty()) {
+    cell = this->free_cells.back();
+    this->free_cells.pop_back();
+  } else {
+    if (this->next_cell == static_cast<size_t>(this->columns * this->rows) &&
+        !this->grow()) {
+      push_unknown();
+      return false;
+    }
+    cell = this->next_cell++;
+  }
+
+  // The whole cell is uploaded so a reused one keeps nothing of its old icon
+  Rectangle rect = this->get_cell(cell);
+  Image cell_image = GenImageColor(this->icon_size, this->icon_size, BLANK);
+  ImageFormat(&cell_image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+  blit(cell_image, *image, 0, 0, this->icon_size, this->icon_size);
+  UpdateTextureRec(this->texture, rect, cell_image.data);
+  UnloadImage(cell_image);
+  GenTextureMipmaps(&this->texture);
+
+  this->cells.emplace(app.icon, Cell{cell, 1});
+  this->slots.push_back(rect);
+  this->slot_icons.push_back(app.icon);
+  return true;
+}
+
+void IconAtlas::erase(size_t app) {
+  if (app >= this->slots.size())
+    return;
+
+  std::string icon = std::move(this->slot_icons[app]);
+  this->slots.erase(this->slots.begin() + app);
+  this->slot_icons.erase(this->slot_icons.begin() + app);
+
+  auto it = this->cells.find(icon);
+  if (it != this->cells.end() && --it->second.users == 0) {
+    this->free_cells.push_back(it->second.index);
+    this->cells.erase(it);
+  }
+}
+
+Rectangle IconAtlas::get_cell(size_t cell) const {
+  int cell_size = this->icon_size + ATLAS_GUTTER * 2;
+  return Rectangle{
+      static_cast<float>((cell % this->columns) * cell_size + ATLAS_GUTTER),
+      static_cast<float>((cell / this->columns) * cell_size + ATLAS_GUTTER),
+      static_cast<float>(this->icon_size),
+      static_cast<float>(this->icon_size),
+  };
+}
+
+bool IconAtlas::grow(void) {
+  // Rows are added below the existing ones so no cell moves and every slot
+  // rectangle stays valid
+  Image old_atlas = LoadImageFromTexture(this->texture);
+  ImageFormat(&old_atlas, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+  int cell_size = this->icon_size + ATLAS_GUTTER * 2;
+  int rows = this->rows * 2;
+  Image atlas = GenImageColor(this->columns * cell_size, rows * cell_size,
+                              BLANK);
+  ImageFormat(&atlas, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+  blit(atlas, old_atlas, 0, 0, old_atlas.width, old_atlas.height);
+  UnloadImage(old_atlas);
+
+  Texture2D texture = LoadTextureFromImage(atlas);
+  UnloadImage(atlas);
+  if (texture.id == 0) {
+    std::println(std::cerr, "[ERROR] Failed to grow icon atlas");
+    return false;
+  }
+
+  UnloadTexture(this->texture);
+  this->texture = texture;
+  this->rows = rows;
+  GenTextureMipmaps(&this->texture);
+  SetTextureFilter(this->texture, TEXTURE_FILTER_TRILINEAR);
+  return true;
+}
+
+size_t IconAtlas::get_memory_size(void) const {
+  size_t size = 0;
+  int width = this->texture.width;
+  int height = this->texture.height;
+  for (int level = 0; level < std::max(this->texture.mipmaps, 1); level++) {
+    size += static_cast<size_t>(width) * height * 4;
+    width = std::max(width / 2, 1);
+    height = std::max(height / 2, 1);
+  }
+
+  return this->texture.id != 0 ? size : 0;
+}
+
+} // namespace hyprdock
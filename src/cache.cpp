@@ -0,0 +1,633 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "cache.hpp"
+#include "desktop.hpp"
+#include "icons.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+namespace hyprdock {
+
+// On-disk layouts, all integers in host byte order:
+//   desktop.cache: CacheHeader, StampRecord[app_stamp_count +
+//                  icon_stamp_count], EntryRecord[entry_count],
+//                  IconRecord[icon_count], string data
+//   icons.cache:   PixelCacheHeader, PixelRecord[icon_count], string data,
+//                  RGBA pixel data
+// Records only refer to strings and pixels by offset, so reading a cache is
+// a bounds check and a copy per field, no text or image is parsed.
+
+static constexpr char CACHE_MAGIC[8] = {'H', 'D', 'C', 'A', 'C', 'H', 'E', 0};
+static constexpr uint32_t CACHE_VERSION = 3;
+
+static constexpr char PIXEL_CACHE_MAGIC[8] = {'H', 'D', 'P', 'I',
+                                              'X', 'E', 'L', 0};
+static constexpr uint32_t PIXEL_CACHE_VERSION = 1;
+
+struct StringRef {
+  uint32_t offset;
+  uint32_t size;
+};
+
+struct CacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t app_stamp_count;
+  uint32_t icon_stamp_count;
+  uint32_t entry_count;
+  uint32_t icon_count;
+  uint32_t strings_size;
+  StringRef key;
+};
+
+struct StampRecord {
+  int64_t mtime;
+  StringRef path;
+};
+
+struct EntryRecord {
+  StringRef id;
+  StringRef path;
+  StringRef name;
+  StringRef comment;
+  StringRef icon_name;
+  StringRef exec;
+  StringRef startup_wm_class;
+  StringRef type;
+};
+
+struct IconRecord {
+  StringRef name;
+  StringRef path;
+};
+
+struct PixelCacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t icon_count;
+  uint32_t strings_size;
+  uint32_t reserved;
+  uint64_t pixels_size;
+};
+
+struct PixelRecord {
+  int64_t mtime;
+  uint64_t pixels_offset;
+  StringRef path;
+  int32_t size;
+  int32_t width;
+  int32_t height;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(CacheHeader) % alignof(StampRecord) == 0);
+static_assert(sizeof(PixelCacheHeader) % alignof(PixelRecord) == 0);
+static_assert(sizeof(StampRecord) % alignof(EntryRecord) == 0);
+
+static int64_t get_mtime(const std::string &path) {
+  struct stat st;
+  if (stat(path.c_str(), &st) == -1)
+    return -1;
+
+  return static_cast<int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 +
+         st.st_mtim.tv_nsec;
+}
+
+static std::vector<DirStamp> get_stamps(const std::vector<fs::path> &dirs) {
+  std::vector<DirStamp> stamps;
+  stamps.reserve(dirs.size());
+  for (const auto &dir : dirs)
+    stamps.push_back({.path = dir.string(), .mtime = get_mtime(dir.string())});
+
+  return stamps;
+}
+
+// Anything that changes which directories get scanned changes the key
+static std::string get_cache_key() {
+  std::string key = get_user_icon_theme();
+  for (const auto &dir : get_application_dirs())
+    key += ":" + dir.string();
+  for (const auto &dir : get_icon_base_dirs())
+    key += ":" + dir.string();
+
+  return key;
+}
+
+fs::path get_cache_dir() {
+  const char *xdg_cache_home = std::getenv("XDG_CACHE_HOME");
+  if (xdg_cache_home && std::strlen(xdg_cache_home) > 0)
+    return fs::path(xdg_cache_home) / "hyprdock";
+
+  const char *home_dir = std::getenv("HOME");
+  if (home_dir && std::strlen(home_dir) > 0)
+    return fs::path(home_dir) / ".cache" / "hyprdock";
+
+  return "";
+}
+
+namespace {
+
+class CacheWriter {
+public:
+  StringRef add_string(const std::string &str) {
+    StringRef ref{
+        .offset = static_cast<uint32_t>(this->strings.size()),
+        .size = static_cast<uint32_t>(str.size()),
+    };
+    this->strings += str;
+    return ref;
+  }
+
+  template <typename T> void add_record(const T &record) {
+    const char *bytes = reinterpret_cast<const char *>(&record);
+    this->records.insert(this->records.end(), bytes, bytes + sizeof(T));
+  }
+
+  uint64_t add_bytes(const void *data, size_t size) {
+    uint64_t offset = this->blob.size();
+    const char *bytes = static_cast<const char *>(data);
+    this->blob.insert(this->blob.end(), bytes, bytes + size);
+    return offset;
+  }
+
+  inline uint32_t get_strings_size(void) const {
+    return static_cast<uint32_t>(this->strings.size());
+  }
+
+  inline uint64_t get_blob_size(void) const {
+    return this->blob.size();
+  }
+
+  template <typename Header>
+  bool write(const fs::path &path, const Header &header) {
+    // Write to a temporary file first so a reader never sees half a cache
+    fs::path tmp_path = path;
+    tmp_path += ".tmp";
+
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                  0644);
+    if (fd == -1)
+      return false;
+
+    bool ok = write_all(fd, &header, sizeof(header)) &&
+              write_all(fd, this->records.data(), this->records.size()) &&
+              write_all(fd, this->strings.data(), this->strings.size()) &&
+              write_all(fd, this->blob.data(), this->blob.size());
+    close(fd);
+
+    if (!ok || rename(tmp_path.c_str(), path.c_str()) == -1) {
+      unlink(tmp_path.c_str());
+      return false;
+    }
+
+    return true;
+  }
+
+private:
+  std::vector<char> records;
+  std::string strings;
+  std::vector<char> blob;
+
+  static bool write_all(int fd, const void *data, size_t size) {
+    const char *bytes = static_cast<const char *>(data);
+    while (size > 0) {
+      ssize_t written = ::write(fd, bytes, size);
+      if (written == -1) {
+        if (errno == EINTR)
+          continue;
+        return false;
+      }
+
+      bytes += written;
+      size -= written;
+    }
+
+    return true;
+  }
+};
+
+class CacheReader {
+public:
+  CacheReader(const char *data, size_t size, size_t header_size)
+      : data(data), size(size), offset(header_size) {
+  }
+
+  template <typename T> const T *get_records(size_t count) {
+    if (count > (this->size - this->offset) / sizeof(T))
+      return nullptr;
+
+    const T *records = reinterpret_cast<const T *>(this->data + this->offset);
+    this->offset += count * sizeof(T);
+    return records;
+  }
+
+  const char *get_bytes(uint64_t count) {
+    if (count > this->size - this->offset)
+      return nullptr;
+
+    const char *bytes = this->data + this->offset;
+    this->offset += count;
+    return bytes;
+  }
+
+  bool set_strings(uint32_t strings_size) {
+    const char *bytes = this->get_bytes(strings_size);
+    if (!bytes)
+      return false;
+
+    this->strings = std::string_view{bytes, strings_size};
+    return true;
+  }
+
+  bool get_string(StringRef ref, std::string &out) const {
+    if (ref.offset > this->strings.size() ||
+        ref.size > this->strings.size() - ref.offset)
+      return false;
+
+    out.assign(this->strings.substr(ref.offset, ref.size));
+    return true;
+  }
+
+private:
+  const char *data;
+  size_t size;
+  size_t offset;
+  std::string_view strings;
+};
+
+} // namespace
+
+static const char *map_file(const fs::path &path, size_t &size) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1)
+    return nullptr;
+
+  struct stat st;
+  if (fstat(fd, &st) == -1 || st.st_size == 0) {
+    close(fd);
+    return nullptr;
+  }
+
+  size = st.st_size;
+  void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED)
+    return nullptr;
+
+  return static_cast<const char *>(mapping);
+}
+
+DesktopCache::DesktopCache(void) {
+  fs::path cache_dir = get_cache_dir();
+  if (cache_dir.empty())
+    return;
+
+  this->path = cache_dir / "desktop.cache";
+  this->key = get_cache_key();
+  this->warm = this->load();
+}
+
+bool DesktopCache::load(void) {
+  size_t size = 0;
+  const char *data = map_file(this->path, size);
+  if (!data)
+    return false;
+
+  if (size < sizeof(CacheHeader)) {
+    munmap(const_cast<char *>(data), size);
+    return false;
+  }
+
+  const auto *header = reinterpret_cast<const CacheHeader *>(data);
+
+  CacheReader reader{data, size, sizeof(CacheHeader)};
+  const StampRecord *stamps = nullptr;
+  const EntryRecord *entries = nullptr;
+  const IconRecord *icon_records = nullptr;
+  std::string key;
+
+  bool ok =
+      std::memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+      header->version == CACHE_VERSION &&
+      (stamps = reader.get_records<StampRecord>(
+           static_cast<size_t>(header->app_stamp_count) +
+           header->icon_stamp_count)) &&
+      (entries = reader.get_records<EntryRecord>(header->entry_count)) &&
+      (icon_records = reader.get_records<IconRecord>(header->icon_count)) &&
+      reader.set_strings(header->strings_size) &&
+      reader.get_string(header->key, key) && key == this->key;
+
+  // Validate every directory before copying anything else out
+  for (uint32_t i = 0;
+       ok && i < header->app_stamp_count + header->icon_stamp_count; i++) {
+    DirStamp stamp{.path = "", .mtime = stamps[i].mtime};
+    ok = reader.get_string(stamps[i].path, stamp.path) &&
+         get_mtime(stamp.path) == stamp.mtime;
+
+    if (i < header->app_stamp_count)
+      this->app_stamps.push_back(std::move(stamp));
+    else
+      this->icon_stamps.push_back(std::move(stamp));
+  }
+
+  std::vector<DesktopEntry> desktop_entries;
+  desktop_entries.reserve(ok ? header->entry_count : 0);
+  for (uint32_t i = 0; ok && i < header->entry_count; i++) {
+    DesktopEntry entry;
+    ok = reader.get_string(entries[i].id, entry.id) &&
+         reader.get_string(entries[i].path, entry.path) &&
+         reader.get_string(entries[i].name, entry.name) &&
+         reader.get_string(entries[i].comment, entry.comment) &&
+         reader.get_string(entries[i].icon_name, entry.icon_name) &&
+         reader.get_string(entries[i].exec, entry.exec) &&
+         reader.get_string(entries[i].startup_wm_class,
+                           entry.startup_wm_class) &&
+         reader.get_string(entries[i].type, entry.type);
+    desktop_entries.push_back(std::move(entry));
+  }
+
+  for (uint32_t i = 0; ok && i < header->icon_count; i++) {
+    std::string name;
+    std::string icon_path;
+    ok = reader.get_string(icon_records[i].name, name) &&
+         reader.get_string(icon_records[i].path, icon_path);
+    this->icons.emplace(std::move(name), std::move(icon_path));
+  }
+
+  munmap(const_cast<char *>(data), size);
+
+  if (!ok) {
+    this->app_stamps.clear();
+    this->icon_stamps.clear();
+    this->icons.clear();
+    return false;
+  }
+
+  this->index = DesktopIndex{std::move(desktop_entries)};
+  this->index_loaded = true;
+  return true;
+}
+
+const DesktopIndex &DesktopCache::get_index(void) {
+  if (!this->index_loaded) {
+    this->index = build_desktop_index();
+    this->app_stamps = get_stamps(this->index.get_scanned_dirs());
+    this->index_loaded = true;
+    this->dirty = true;
+  }
+
+  return this->index;
+}
+
+std::string DesktopCache::resolve_icon(const std::string &icon_name,
+                                       int desired_size) {
+  if (icon_name.empty())
+    return "";
+
+  std::string cache_key = icon_name + "@" + std::to_string(desired_size);
+  auto it = this->icons.find(cache_key);
+  if (it != this->icons.end())
+    return it->second;
+
+  std::string icon_path = resolve_app_icon(icon_name, desired_size);
+  this->icons.emplace(std::move(cache_key), icon_path);
+  this->icons_scanned = true;
+  this->dirty = true;
+  return icon_path;
+}
+
+void DesktopCache::save(void) {
+  if (!this->dirty || this->path.empty())
+    return;
+
+  if (this->icons_scanned)
+    this->icon_stamps = get_stamps(get_icon_lookup().get_scanned_dirs());
+
+  std::error_code ec;
+  fs::create_directories(this->path.parent_path(), ec);
+
+  CacheWriter writer;
+  CacheHeader header{};
+  std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  header.version = CACHE_VERSION;
+  header.app_stamp_count = static_cast<uint32_t>(this->app_stamps.size());
+  header.icon_stamp_count = static_cast<uint32_t>(this->icon_stamps.size());
+  header.entry_count = static_cast<uint32_t>(this->index.size());
+  header.icon_count = static_cast<uint32_t>(this->icons.size());
+  header.key = writer.add_string(this->key);
+
+  for (const auto &stamps : {&this->app_stamps, &this->icon_stamps}) {
+    for (const auto &stamp : *stamps)
+      writer.add_record(StampRecord{
+          .mtime = stamp.mtime,
+          .path = writer.add_string(stamp.path),
+      });
+  }
+
+  for (const auto &entry : this->index.get_entries())
+    writer.add_record(EntryRecord{
+        .id = writer.add_string(entry.id),
+        .path = writer.add_string(entry.path),
+        .name = writer.add_string(entry.name),
+        .comment = writer.add_string(entry.comment),
+        .icon_name = writer.add_string(entry.icon_name),
+        .exec = writer.add_string(entry.exec),
+        .startup_wm_class = writer.add_string(entry.startup_wm_class),
+        .type = writer.add_string(entry.type),
+    });
+
+  for (const auto &[name, icon_path] : this->icons)
+    writer.add_record(IconRecord{
+        .name = writer.add_string(name),
+        .path = writer.add_string(icon_path),
+    });
+
+  header.strings_size = writer.get_strings_size();
+  if (!writer.write(this->path, header))
+    std::println(std::cerr, "[WARNING] Failed to write cache: {}",
+                 this->path.string());
+  else
+    this->dirty = false;
+}
+
+static std::string get_pixel_key(const std::string &path, int size) {
+  return path + "@" + std::to_string(size);
+}
+
+IconPixelCache::IconPixelCache(void) {
+  fs::path cache_dir = get_cache_dir();
+  if (cache_dir.empty())
+    return;
+
+  this->path = cache_dir / "icons.cache";
+
+  size_t size = 0;
+  const char *data = map_file(this->path, size);
+  if (!data)
+    return;
+
+  this->mapping = data;
+  this->mapping_size = size;
+
+  if (size < sizeof(PixelCacheHeader))
+    return;
+
+  const auto *header = reinterpret_cast<const PixelCacheHeader *>(data);
+  if (std::memcmp(header->magic, PIXEL_CACHE_MAGIC,
+                  sizeof(PIXEL_CACHE_MAGIC)) != 0 ||
+      header->version != PIXEL_CACHE_VERSION)
+    return;
+
+  CacheReader reader{data, size, sizeof(PixelCacheHeader)};
+  const auto *records = reader.get_records<PixelRecord>(header->icon_count);
+  const char *pixels = nullptr;
+  if (!records || !reader.set_strings(header->strings_size) ||
+      !(pixels = reader.get_bytes(header->pixels_size)))
+    return;
+
+  for (uint32_t i = 0; i < header->icon_count; i++) {
+    const auto &record = records[i];
+    uint64_t pixels_size = static_cast<uint64_t>(record.width) *
+                           static_cast<uint64_t>(record.height) * 4;
+
+    std::string icon_path;
+    if (record.width <= 0 || record.height <= 0 ||
+        record.pixels_offset > header->pixels_size ||
+        pixels_size > header->pixels_size - record.pixels_offset ||
+        !reader.get_string(record.path, icon_path))
+      continue;
+
+    this->icons.emplace(
+        get_pixel_key(icon_path, record.size),
+        PixelIcon{
+            .path = icon_path,
+            .mtime = record.mtime,
+            .size = record.size,
+            .width = record.width,
+            .height = record.height,
+            .pixels = reinterpret_cast<const unsigned char *>(
+                pixels + record.pixels_offset),
+            .decoded = {},
+        });
+  }
+}
+
+IconPixelCache::~IconPixelCache(void) {
+  if (this->mapping)
+    munmap(const_cast<char *>(this->mapping), this->mapping_size);
+}
+
+std::optional<Image> IconPixelCache::load_image(const std::string &icon_path,
+                                                int size) {
+  std::string key = get_pixel_key(icon_path, size);
+  int64_t mtime = get_mtime(icon_path);
+
+  auto it = this->icons.find(key);
+  if (it == this->icons.end() || it->second.mtime != mtime) {
+    // Decode and resample once, later starts upload the stored pixels as is
+    Image image = LoadImage(icon_path.c_str());
+    if (!image.data)
+      return std::nullopt;
+
+    ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    if (image.width != size || image.height != size)
+      ImageResize(&image, size, size);
+
+    PixelIcon icon{
+        .path = icon_path,
+        .mtime = mtime,
+        .size = size,
+        .width = image.width,
+        .height = image.height,
+        .pixels = nullptr,
+        .decoded = {},
+    };
+
+    const auto *bytes = static_cast<const unsigned char *>(image.data);
+    icon.decoded.assign(bytes, bytes + static_cast<size_t>(image.width) *
+                                           image.height * 4);
+    icon.pixels = icon.decoded.data();
+    UnloadImage(image);
+
+    it = this->icons.insert_or_assign(std::move(key), std::move(icon)).first;
+    this->dirty = true;
+  }
+
+  it->second.used = true;
+
+  const PixelIcon &icon = it->second;
+  return Image{
+      .data = const_cast<unsigned char *>(icon.pixels),
+      .width = icon.width,
+      .height = icon.height,
+      .mipmaps = 1,
+      .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+  };
+}
+
+void IconPixelCache::save(void) {
+  if (this->path.empty())
+    return;
+
+  // Icons that were not asked for this time are dropped with the rewrite
+  bool unused = std::any_of(this->icons.begin(), this->icons.end(),
+                            [](const auto &icon) {
+                              return !icon.second.used;
+                            });
+  if (!this->dirty && !unused)
+    return;
+
+  std::error_code ec;
+  fs::create_directories(this->path.parent_path(), ec);
+
+  CacheWriter writer;
+  PixelCacheHeader header{};
+  std::memcpy(header.magic, PIXEL_CACHE_MAGIC, sizeof(PIXEL_CACHE_MAGIC));
+  header.version = PIXEL_CACHE_VERSION;
+
+  for (const auto &[key, icon] : this->icons) {
+    if (!icon.used)
+      continue;
+
+    size_t pixels_size = static_cast<size_t>(icon.width) * icon.height * 4;
+    writer.add_record(PixelRecord{
+        .mtime = icon.mtime,
+        .pixels_offset = writer.add_bytes(icon.pixels, pixels_size),
+        .path = writer.add_string(icon.path),
+        .size = icon.size,
+        .width = icon.width,
+        .height = icon.height,
+        .reserved = 0,
+    });
+    header.icon_count++;
+  }
+
+  header.strings_size = writer.get_strings_size();
+  header.pixels_size = writer.get_blob_size();
+  if (!writer.write(this->path, header))
+    std::println(std::cerr, "[WARNING] Failed to write cache: {}",
+                 this->path.string());
+  else
+    this->dirty = false;
+}
+
+} // namespace hyprdock
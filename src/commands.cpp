@@ -2,16 +2,58 @@
 #include <nlohmann/json.hpp>
 #include <print>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "commands.hpp"
+#include "decode.hpp"
 #include "ipc.hpp"
 #include "utils.hpp"
 
-namespace fs = std::filesystem;
 using json = nlohmann::json;
 
+ClientSnapshot::ClientSnapshot(std::vector<Client> clients)
+    : clients(std::move(clients)) {
+  // Indexes keep the first client for each key, like the linear scans did
+  for (size_t i = 0; i < this->clients.size(); i++) {
+    const auto &client = this->clients[i];
+    this->by_address.emplace(client.address, i);
+    this->by_title.emplace(client.title, i);
+    this->by_class.emplace(client.class_name, i);
+    this->by_pid.emplace(client.pid, i);
+  }
+}
+
+const Client *
+ClientSnapshot::find_by_address(const std::string &address) const {
+  auto it = this->by_address.find(address);
+  return it == this->by_address.end() ? nullptr : &this->clients[it->second];
+}
+
+const Client *ClientSnapshot::find_by_title(const std::string &title) const {
+  auto it = this->by_title.find(title);
+  return it == this->by_title.end() ? nullptr : &this->clients[it->second];
+}
+
+const Client *
+ClientSnapshot::find_by_class(const std::string &class_name) const {
+  auto it = this->by_class.find(class_name);
+  return it == this->by_class.end() ? nullptr : &this->clients[it->second];
+}
+
+const Client *ClientSnapshot::find_by_pid(int pid) const {
+  auto it = this->by_pid.find(pid);
+  return it == this->by_pid.end() ? nullptr : &this->clients[it->second];
+}
+
+void ClientSnapshot::move_client(const std::string &address,
+                                 const std::string &workspace) {
+  auto it = this->by_address.find(address);
+  if (it != this->by_address.end())
+    this->clients[it->second].workspace = workspace;
+}
+
 namespace hyprland::command {
 
 std::vector<Monitor> get_monitors(const std::string &sock_path) {
@@ -21,33 +63,13 @@ std::vector<Monitor> get_monitors(const std::string &sock_path) {
     return {};
   }
 
-  try {
-    json resp = json::parse(*raw_resp);
-    std::vector<Monitor> result{};
-
-    if (resp.is_array()) {
-      for (const auto &monitor : resp) {
-        if (monitor.contains("id") && monitor["id"].is_number() &&
-            monitor.contains("width") && monitor["width"].is_number() &&
-            monitor.contains("height") && monitor["height"].is_number()) {
-          result.push_back({
-              .id = monitor["id"].get<int>(),
-              .width = monitor["width"].get<int>(),
-              .height = monitor["height"].get<int>(),
-          });
-        }
-      }
-    } else {
-      std::println(std::cerr, "[ERROR] Monitors IPC response not an array");
-      return {};
-    }
-
-    return result;
-  } catch (const json::parse_error &e) {
-    std::println(std::cerr, "[ERROR] Failed to parse monitors IPC response: {}",
-                 e.what());
+  auto monitors = hyprland::decode::decode_monitors(*raw_resp);
+  if (!monitors) {
+    std::println(std::cerr, "[ERROR] {}", monitors.error());
     return {};
   }
+
+  return std::move(*monitors);
 }
 
 std::pair<int, int> get_mouse_position(const std::string &sock_path) {
@@ -57,148 +79,91 @@ std::pair<int, int> get_mouse_position(const std::string &sock_path) {
     return {-1, -1};
   }
 
-  try {
-    json resp = json::parse(*raw_resp);
-
-    if (resp.contains("x") && resp["x"].is_number() && resp.contains("y") &&
-        resp["y"].is_number()) {
-      return {
-          resp["x"].get<int>(),
-          resp["y"].get<int>(),
-      };
-    } else {
-      std::println(std::cerr, "[ERROR] Cursorpos IPC response is invalid");
-      return {-1, -1};
-    }
-  } catch (const json::parse_error &e) {
-    std::println(std::cerr,
-                 "[ERROR] Failed to parse cursorpos IPC response: {}",
-                 e.what());
+  auto mouse_pos = hyprland::decode::decode_cursor_pos(*raw_resp);
+  if (!mouse_pos) {
+    std::println(std::cerr, "[ERROR] {}", mouse_pos.error());
     return {-1, -1};
   }
+
+  return *mouse_pos;
 }
 
-std::string hide_window(const std::string &title,
-                        const std::string &sock_path) {
+ClientSnapshot get_clients(const std::string &sock_path) {
   auto raw_resp = hyprland::IPC::send_command("j/clients", sock_path);
   if (!raw_resp) {
     std::println(std::cerr, "[ERROR] {}", raw_resp.error());
     return {};
   }
 
-  try {
-    json resp = json::parse(*raw_resp);
-
-    if (resp.is_array()) {
-      std::string target_address = "";
-      std::string target_workspace = "";
-
-      for (const auto &client : resp) {
-        if (client.contains("title") && client["title"].is_string() &&
-            client.contains("address") && client["address"].is_string() &&
-            client.contains("workspace") && client["workspace"].is_object() &&
-            client["workspace"].contains("name") &&
-            client["workspace"]["name"].is_string()) {
-          if (client["title"].get<std::string>() == title) {
-            target_address = client["address"].get<std::string>();
-            target_workspace = client["workspace"]["name"].get<std::string>();
-            break;
-          }
-        }
-      }
-
-      if (target_address.empty()) {
-        std::println(std::cerr, "[ERROR] Window with title '{}' not found",
-                     title);
-        return "";
-      }
+  auto clients = hyprland::decode::decode_clients(*raw_resp);
+  if (!clients) {
+    std::println(std::cerr, "[ERROR] {}", clients.error());
+    return {};
+  }
 
-      std::string command =
-          "dispatch movetoworkspacesilent special:hidden_apps,address:" +
-          target_address;
-      auto _ = hyprland::IPC::send_command(command, sock_path);
+  return ClientSnapshot{std::move(*clients)};
+}
 
-      return target_workspace;
-    } else {
-      std::println(std::cerr, "[ERROR] Clients IPC response not an array");
-      return "";
-    }
-  } catch (const json::parse_error &e) {
-    std::println(std::cerr, "[ERROR] Failed to parse clients IPC response: {}",
-                 e.what());
+std::string hide_window(const std::string &title, const ClientSnapshot &clients,
+                        hyprland::IPC::Batch &batch) {
+  const Client *target = clients.find_by_title(title);
+  if (!target) {
+    std::println(std::cerr, "[ERROR] Window with title '{}' not found", title);
     return "";
   }
+
+  batch.dispatch("movetoworkspacesilent special:hidden_apps,address:" +
+                 target->address);
+
+  return target->workspace;
 }
 
 std::string move_window_to_workspace(const std::string &title,
                                      const std::string &workspace,
-                                     const std::string &sock_path) {
-  auto raw_resp = hyprland::IPC::send_command("j/clients", sock_path);
-  if (!raw_resp) {
-    std::println(std::cerr, "[ERROR] {}", raw_resp.error());
-    return {};
+                                     const ClientSnapshot &clients,
+                                     hyprland::IPC::Batch &batch) {
+  if (workspace.empty()) {
+    std::println(std::cerr, "[ERROR] No workspace to move '{}' to", title);
+    return "";
   }
 
-  try {
-    json resp = json::parse(*raw_resp);
-
-    if (resp.is_array()) {
-      std::string target_address = "";
-      std::string target_workspace = "";
-
-      for (const auto &client : resp) {
-        if (client.contains("title") && client["title"].is_string() &&
-            client.contains("address") && client["address"].is_string() &&
-            client.contains("workspace") && client["workspace"].is_object() &&
-            client["workspace"].contains("name") &&
-            client["workspace"]["name"].is_string()) {
-          if (client["title"].get<std::string>() == title) {
-            target_address = client["address"].get<std::string>();
-            target_workspace = client["workspace"]["name"].get<std::string>();
-            break;
-          }
-        }
-      }
+  const Client *target = clients.find_by_title(title);
+  if (!target) {
+    std::println(std::cerr, "[ERROR] Window with title '{}' not found", title);
+    return "";
+  }
 
-      if (target_address.empty()) {
-        std::println(std::cerr, "[ERROR] Window with title '{}' not found",
-                     title);
-        return "";
-      }
+  batch.dispatch("movetoworkspace name:" + workspace +
+                 ",address:" + target->address);
 
-      std::string command;
-      if (workspace.empty()) {
-        std::string active_workspace = get_active_workspace(sock_path);
-        if (active_workspace.empty())
-          return "";
-
-        command = "dispatch movetoworkspace name:" + active_workspace +
-                  ",address:" + target_address;
-      } else {
-        command = "dispatch movetoworkspace name:" + workspace +
-                  ",address:" + target_address;
-      }
+  return target->workspace;
+}
 
-      auto _ = hyprland::IPC::send_command(command, sock_path);
+std::string move_window_to_workspace_silent(const std::string &title,
+                                            const std::string &workspace,
+                                            const ClientSnapshot &clients,
+                                            hyprland::IPC::Batch &batch) {
+  if (workspace.empty()) {
+    std::println(std::cerr, "[ERROR] No workspace to move '{}' to", title);
+    return "";
+  }
 
-      return target_workspace;
-    } else {
-      std::println(std::cerr, "[ERROR] Clients IPC response not an array");
-      return "";
-    }
-  } catch (const json::parse_error &e) {
-    std::println(std::cerr, "[ERROR] Failed to parse clients IPC response: {}",
-                 e.what());
+  const Client *target = clients.find_by_title(title);
+  if (!target) {
+    std::println(std::cerr, "[ERROR] Window with title '{}' not found", title);
     return "";
   }
+
+  batch.dispatch("movetoworkspacesilent name:" + workspace +
+                 ",address:" + target->address);
+
+  return target->workspace;
 }
 
 void move_mouse(const std::pair<int, int> mouse_pos,
-                const std::string &sock_path) {
-  std::string command = "dispatch movecursor " +
-                        std::to_string(mouse_pos.first) + " " +
-                        std::to_string(mouse_pos.second);
-  auto _ = hyprland::IPC::send_command(command, sock_path);
+                hyprland::IPC::Batch &batch) {
+  batch.dispatch("movecursor " + std::to_string(mouse_pos.first) + " " +
+                 std::to_string(mouse_pos.second));
 }
 
 std::string get_active_workspace(const std::string &sock_path) {
@@ -208,22 +173,13 @@ std::string get_active_workspace(const std::string &sock_path) {
     return "";
   }
 
-  try {
-    json resp = json::parse(*raw_resp);
-
-    if (resp.contains("name") && resp["name"].is_string()) {
-      return resp["name"].get<std::string>();
-    } else {
-      std::println(std::cerr,
-                   "[ERROR] Activeworkspace IPC response is invalid");
-      return "";
-    }
-  } catch (const json::parse_error &e) {
-    std::println(std::cerr,
-                 "[ERROR] Failed to parse activeworkspace IPC response: {}",
-                 e.what());
+  auto workspace = hyprland::decode::decode_workspace_name(*raw_resp);
+  if (!workspace) {
+    std::println(std::cerr, "[ERROR] {}", workspace.error());
     return "";
   }
+
+  return std::move(*workspace);
 }
 
 // TODO: FIx this
@@ -271,76 +227,23 @@ bool is_empty_workspace(const std::string &uuid, const std::string &workspace,
   return false;
 }
 
-std::string get_window_from_proc(const std::string &proc,
-                                 const std::string &sock_path) {
-  auto raw_resp = hyprland::IPC::send_command("j/clients", sock_path);
-  if (!raw_resp) {
-    std::println(std::cerr, "[ERROR] {}", raw_resp.error());
-    return {};
-  }
-
-  try {
-    json resp = json::parse(*raw_resp);
-
-    if (resp.is_array()) {
-      std::string target_address = "";
-
-      for (const auto &client : resp) {
-        if (client.contains("pid") && client["pid"].is_number() &&
-            client.contains("address") && client["address"].is_string()) {
-          std::string pid = std::to_string(client["pid"].get<int>());
-          std::string client_proc = hyprdock::get_name_from_pid(pid);
-          if (client_proc.empty())
-            continue;
-
-          fs::path client_proc_path{client_proc};
-          std::string client_proc_name = client_proc_path.filename().string();
-
-          fs::path proc_path{proc};
-          std::string proc_name = proc_path.filename().string();
-
-          if (client_proc_name == proc_name) {
-            target_address = client["address"].get<std::string>();
-            break;
-          }
-        }
-      }
-
-      if (target_address.empty())
-        return "";
-
-      return target_address;
-    } else {
-      std::println(std::cerr, "[ERROR] Clients IPC response not an array");
-      return "";
-    }
-  } catch (const json::parse_error &e) {
-    std::println(std::cerr, "[ERROR] Failed to parse clients IPC response: {}",
-                 e.what());
-    return "";
-  }
+void exec(const std::string &command, hyprland::IPC::Batch &batch) {
+  batch.dispatch("exec " + command);
 }
 
-void focus_window(const std::string &address, const std::string &sock_path) {
-  std::string command = "dispatch focuswindow address:" + address;
-  auto _ = hyprland::IPC::send_command(command, sock_path);
+void focus_window(const std::string &address, hyprland::IPC::Batch &batch) {
+  batch.dispatch("focuswindow address:" + address);
 }
 
-void set_plain_window(const std::string &uuid, const std::string &sock_path) {
-  std::string command = "keyword windowrulev2 noborder,title:" + uuid;
-  auto _ = hyprland::IPC::send_command(command, sock_path);
-
-  command = "keyword windowrulev2 decorate:false,title:" + uuid;
-  _ = hyprland::IPC::send_command(command, sock_path);
-
-  command = "keyword windowrulev2 noshadow,title:" + uuid;
-  _ = hyprland::IPC::send_command(command, sock_path);
+void set_plain_window(const std::string &uuid, hyprland::IPC::Batch &batch) {
+  batch.keyword("windowrulev2 noborder,title:" + uuid);
+  batch.keyword("windowrulev2 decorate:false,title:" + uuid);
+  batch.keyword("windowrulev2 noshadow,title:" + uuid);
 }
 
 void set_unmoveable_window(const std::string &uuid,
-                           const std::string &sock_path) {
-  std::string command = "keyword windowrulev2 nomove,title:" + uuid;
-  auto _ = hyprland::IPC::send_command(command, sock_path);
+                           hyprland::IPC::Batch &batch) {
+  batch.keyword("windowrulev2 nomove,title:" + uuid);
 }
 
 } // namespace hyprland::command
@@ -1,3 +1,4 @@
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
@@ -6,9 +7,12 @@
 #include <nlohmann/json.hpp>
 #include <print>
 #include <pwd.h>
+#include <string_view>
 #include <unistd.h>
 
+#include "cache.hpp"
 #include "config.hpp"
+#include "desktop.hpp"
 #include "utils.hpp"
 
 namespace fs = std::filesystem;
@@ -19,6 +23,9 @@ namespace hyprdock {
 static Config default_config = {
     .monitor = 0,
     .wait_time = 300,
+    .edge_trigger = false,
+    .launch_backend = LaunchBackend::Spawn,
+    .taskbar = false,
 
     .dock_padding = 10,
     .dock_margin = 10,
@@ -30,7 +37,25 @@ static Config default_config = {
     .applications = {},
 };
 
-Config load_config() {
+Options parse_options(int argc, char **argv) {
+  Options options;
+
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg{argv[i]};
+    if (arg == "--stats")
+      options.stats = true;
+    else if (arg == "--timing")
+      options.timing = true;
+    else if (arg == "--draw-calls")
+      options.draw_calls = true;
+    else
+      std::println(std::cerr, "[WARNING] Unknown option: {}", arg);
+  }
+
+  return options;
+}
+
+Config load_config(const Options &options, DesktopCache &desktop_cache) {
   fs::path config_file;
 
   const char *xdg_config_home = std::getenv("XDG_CONFIG_HOME");
@@ -75,6 +100,21 @@ Config load_config() {
     if (config_json.contains("wait_time") &&
         config_json["wait_time"].is_number())
       loaded_config.wait_time = config_json["wait_time"].get<int>();
+    if (config_json.contains("edge_trigger") &&
+        config_json["edge_trigger"].is_boolean())
+      loaded_config.edge_trigger = config_json["edge_trigger"].get<bool>();
+    if (config_json.contains("launcher") &&
+        config_json["launcher"].is_string()) {
+      std::string launcher = config_json["launcher"].get<std::string>();
+      if (launcher == "hyprland")
+        loaded_config.launch_backend = LaunchBackend::Hyprland;
+      else if (launcher == "spawn")
+        loaded_config.launch_backend = LaunchBackend::Spawn;
+      else
+        std::println(std::cerr, "[WARNING] Unknown launcher: {}", launcher);
+    }
+    if (config_json.contains("taskbar") && config_json["taskbar"].is_boolean())
+      loaded_config.taskbar = config_json["taskbar"].get<bool>();
     if (config_json.contains("dock_style") &&
         config_json["dock_style"].is_object()) {
       json dock_style = config_json["dock_style"];
@@ -102,17 +142,20 @@ Config load_config() {
     }
     if (config_json.contains("applications") &&
         config_json["applications"].is_array()) {
+      auto start_time = std::chrono::steady_clock::now();
+      const DesktopIndex &desktop_index = desktop_cache.get_index();
+
       for (const auto &app : config_json["applications"]) {
         if (app.is_string()) {
           std::string app_name = app.get<std::string>();
-          auto desktop_entry = get_entry_for_name(app_name);
+          auto desktop_entry = desktop_index.find(app_name);
 
           if (desktop_entry)
             loaded_config.applications.push_back(*desktop_entry);
         } else if (app.is_object()) {
           if (app.contains("name") && app["name"].is_string()) {
             std::string app_name = app["name"].get<std::string>();
-            auto desktop_entry = get_entry_for_name(app_name);
+            auto desktop_entry = desktop_index.find(app_name);
 
             if (desktop_entry) {
               if (app.contains("icon") && app["icon"].is_string()) {
@@ -124,6 +167,16 @@ Config load_config() {
           }
         }
       }
+
+      if (options.timing) {
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start_time;
+        std::println("[TIMING] {} start: indexed {} desktop entries and "
+                     "found {} apps in {:.2f} ms",
+                     desktop_cache.is_warm() ? "Warm" : "Cold",
+                     desktop_index.size(), loaded_config.applications.size(),
+                     elapsed.count());
+      }
     }
 
     return loaded_config;
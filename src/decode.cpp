@@ -0,0 +1,345 @@
+#include <cstddef>
+#include <expected>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "commands.hpp"
+#include "decode.hpp"
+
+using json = nlohmann::json;
+
+namespace hyprland::decode {
+
+// SAX handler that tracks the key of every enclosing object and forwards
+// scalar values to the derived decoder. Depth 1 is the top level value.
+template <typename Derived> class FieldSax {
+public:
+  bool null() {
+    return true;
+  }
+
+  bool boolean(bool) {
+    return true;
+  }
+
+  bool number_integer(json::number_integer_t value) {
+    this->derived().on_number(static_cast<double>(value));
+    return true;
+  }
+
+  bool number_unsigned(json::number_unsigned_t value) {
+    this->derived().on_number(static_cast<double>(value));
+    return true;
+  }
+
+  bool number_float(json::number_float_t value, const json::string_t &) {
+    this->derived().on_number(static_cast<double>(value));
+    return true;
+  }
+
+  bool string(json::string_t &value) {
+    this->derived().on_string(value);
+    return true;
+  }
+
+  bool binary(json::binary_t &) {
+    return true;
+  }
+
+  bool start_object(std::size_t) {
+    this->push(false);
+    this->derived().on_start_object();
+    return true;
+  }
+
+  bool end_object() {
+    this->derived().on_end_object();
+    this->pop();
+    return true;
+  }
+
+  bool start_array(std::size_t) {
+    this->push(true);
+    return true;
+  }
+
+  bool end_array() {
+    this->pop();
+    return true;
+  }
+
+  bool key(json::string_t &value) {
+    this->path[this->depth] = value;
+    return true;
+  }
+
+  bool parse_error(std::size_t, const std::string &,
+                   const nlohmann::detail::exception &e) {
+    this->error = e.what();
+    return false;
+  }
+
+  // Default hooks, decoders hide the ones they need
+  void on_start_object() {}
+  void on_end_object() {}
+  void on_string(std::string &) {}
+  void on_number(double) {}
+
+  std::string error;
+
+protected:
+  std::size_t depth = 0;
+  bool root_is_array = false;
+  bool root_is_object = false;
+
+  inline const std::string &get_key(void) const {
+    return this->path[this->depth];
+  }
+
+  inline const std::string &get_parent_key(void) const {
+    return this->path[this->depth - 1];
+  }
+
+private:
+  std::vector<std::string> path{1};
+
+  inline Derived &derived(void) {
+    return static_cast<Derived &>(*this);
+  }
+
+  void push(bool is_array) {
+    if (this->depth == 0) {
+      this->root_is_array = is_array;
+      this->root_is_object = !is_array;
+    }
+
+    this->depth++;
+    if (this->path.size() <= this->depth)
+      this->path.emplace_back();
+    this->path[this->depth].clear();
+  }
+
+  void pop(void) {
+    this->path[this->depth].clear();
+    this->depth--;
+  }
+};
+
+template <typename Sax>
+static bool run_sax(std::string_view reply, Sax &sax) {
+  try {
+    return json::sax_parse(reply, &sax) && sax.error.empty();
+  } catch (const json::exception &e) {
+    sax.error = e.what();
+    return false;
+  }
+}
+
+class MonitorsSax : public FieldSax<MonitorsSax> {
+public:
+  std::vector<Monitor> monitors;
+
+  void on_start_object() {
+    if (this->depth == 2) {
+      this->current = Monitor{};
+      this->fields = 0;
+    }
+  }
+
+  void on_end_object() {
+    if (this->depth == 2 && this->fields == ALL_FIELDS)
+      this->monitors.push_back(this->current);
+  }
+
+  void on_number(double value) {
+    if (this->depth != 2)
+      return;
+
+    const std::string &key = this->get_key();
+    if (key == "id") {
+      this->current.id = static_cast<int>(value);
+      this->fields |= ID;
+    } else if (key == "width") {
+      this->current.width = static_cast<int>(value);
+      this->fields |= WIDTH;
+    } else if (key == "height") {
+      this->current.height = static_cast<int>(value);
+      this->fields |= HEIGHT;
+    } else if (key == "scale" && value > 0.0) {
+      // Optional, older Hyprland versions do not report it
+      this->current.scale = static_cast<float>(value);
+    }
+  }
+
+  inline bool is_valid(void) const {
+    return this->root_is_array;
+  }
+
+private:
+  enum : unsigned { ID = 1, WIDTH = 2, HEIGHT = 4, ALL_FIELDS = 7 };
+
+  Monitor current{};
+  unsigned fields = 0;
+};
+
+class CursorPosSax : public FieldSax<CursorPosSax> {
+public:
+  int x = 0;
+  int y = 0;
+
+  void on_number(double value) {
+    if (this->depth != 1)
+      return;
+
+    if (this->get_key() == "x") {
+      this->x = static_cast<int>(value);
+      this->fields |= X;
+    } else if (this->get_key() == "y") {
+      this->y = static_cast<int>(value);
+      this->fields |= Y;
+    }
+  }
+
+  inline bool is_valid(void) const {
+    return this->root_is_object && this->fields == ALL_FIELDS;
+  }
+
+private:
+  enum : unsigned { X = 1, Y = 2, ALL_FIELDS = 3 };
+
+  unsigned fields = 0;
+};
+
+class WorkspaceSax : public FieldSax<WorkspaceSax> {
+public:
+  std::string name;
+  bool has_name = false;
+
+  void on_string(std::string &value) {
+    if (this->depth == 1 && this->get_key() == "name") {
+      this->name = std::move(value);
+      this->has_name = true;
+    }
+  }
+
+  inline bool is_valid(void) const {
+    return this->root_is_object && this->has_name;
+  }
+};
+
+class ClientsSax : public FieldSax<ClientsSax> {
+public:
+  std::vector<Client> clients;
+
+  void on_start_object() {
+    if (this->depth == 2) {
+      this->current = Client{};
+      this->fields = 0;
+    }
+  }
+
+  void on_end_object() {
+    if (this->depth == 2 && this->fields == ALL_FIELDS)
+      this->clients.push_back(std::move(this->current));
+  }
+
+  void on_string(std::string &value) {
+    if (this->depth == 2) {
+      const std::string &key = this->get_key();
+      if (key == "address") {
+        this->current.address = std::move(value);
+        this->fields |= ADDRESS;
+      } else if (key == "title") {
+        this->current.title = std::move(value);
+        this->fields |= TITLE;
+      } else if (key == "class") {
+        this->current.class_name = std::move(value);
+        this->fields |= CLASS;
+      } else if (key == "initialClass") {
+        // Optional, some clients change their class after mapping
+        this->current.initial_class = std::move(value);
+      }
+    } else if (this->depth == 3 && this->get_parent_key() == "workspace" &&
+               this->get_key() == "name") {
+      this->current.workspace = std::move(value);
+      this->fields |= WORKSPACE;
+    }
+  }
+
+  void on_number(double value) {
+    if (this->depth == 2 && this->get_key() == "pid") {
+      this->current.pid = static_cast<int>(value);
+      this->fields |= PID;
+    }
+  }
+
+  inline bool is_valid(void) const {
+    return this->root_is_array;
+  }
+
+private:
+  enum : unsigned {
+    ADDRESS = 1,
+    TITLE = 2,
+    CLASS = 4,
+    WORKSPACE = 8,
+    PID = 16,
+    ALL_FIELDS = 31,
+  };
+
+  Client current{};
+  unsigned fields = 0;
+};
+
+std::expected<std::vector<Monitor>, std::string>
+decode_monitors(std::string_view reply) {
+  MonitorsSax sax;
+  if (!run_sax(reply, sax))
+    return std::unexpected{"Failed to parse monitors IPC response: " +
+                           sax.error};
+  if (!sax.is_valid())
+    return std::unexpected{"Monitors IPC response not an array"};
+
+  return std::move(sax.monitors);
+}
+
+std::expected<std::pair<int, int>, std::string>
+decode_cursor_pos(std::string_view reply) {
+  CursorPosSax sax;
+  if (!run_sax(reply, sax))
+    return std::unexpected{"Failed to parse cursorpos IPC response: " +
+                           sax.error};
+  if (!sax.is_valid())
+    return std::unexpected{"Cursorpos IPC response is invalid"};
+
+  return std::pair<int, int>{sax.x, sax.y};
+}
+
+std::expected<std::string, std::string>
+decode_workspace_name(std::string_view reply) {
+  WorkspaceSax sax;
+  if (!run_sax(reply, sax))
+    return std::unexpected{"Failed to parse activeworkspace IPC response: " +
+                           sax.error};
+  if (!sax.is_valid())
+    return std::unexpected{"Activeworkspace IPC response is invalid"};
+
+  return std::move(sax.name);
+}
+
+std::expected<std::vector<Client>, std::string>
+decode_clients(std::string_view reply) {
+  ClientsSax sax;
+  if (!run_sax(reply, sax))
+    return std::unexpected{"Failed to parse clients IPC response: " +
+                           sax.error};
+  if (!sax.is_valid())
+    return std::unexpected{"Clients IPC response not an array"};
+
+  return std::move(sax.clients);
+}
+
+} // namespace hyprland::decode
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "desktop.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+namespace hyprdock {
+
+// Desktop-file ID as defined by the desktop entry spec, the path below the
+// applications directory with '/' replaced by '-' and without the extension
+static std::string get_desktop_id(const fs::path &app_dir,
+                                  const fs::path &path) {
+  std::string id =
+      path.lexically_relative(app_dir).replace_extension().string();
+  std::replace(id.begin(), id.end(), '/', '-');
+  return id;
+}
+
+DesktopIndex::DesktopIndex(const std::vector<fs::path> &app_dirs) {
+  std::unordered_set<std::string> seen_ids;
+
+  for (const auto &dir : app_dirs) {
+    // Missing directories are recorded too, creating one has to be noticed
+    this->scanned_dirs.push_back(dir);
+
+    std::error_code ec;
+    if (!fs::is_directory(dir, ec))
+      continue;
+
+    // Walked with an explicit stack so a subdirectory that cannot be opened
+    // or read is skipped while its siblings are still scanned
+    std::vector<fs::directory_iterator> pending;
+    pending.emplace_back(dir, fs::directory_options::skip_permission_denied,
+                         ec);
+    if (ec)
+      continue;
+
+    while (!pending.empty()) {
+      auto &it = pending.back();
+      if (it == fs::directory_iterator()) {
+        pending.pop_back();
+        continue;
+      }
+
+      fs::directory_entry entry = *it;
+      it.increment(ec);
+      if (ec)
+        it = fs::directory_iterator();
+
+      if (entry.is_directory(ec)) {
+        this->scanned_dirs.push_back(entry.path());
+
+        // Symlinked directories are not followed, they could form a cycle
+        if (entry.is_symlink(ec))
+          continue;
+
+        fs::directory_iterator child(
+            entry.path(), fs::directory_options::skip_permission_denied, ec);
+        if (!ec)
+          pending.push_back(std::move(child));
+        continue;
+      }
+
+      if (!entry.is_regular_file(ec) || entry.path().extension() != ".desktop")
+        continue;
+
+      // Higher precedence directories shadow entries with the same ID, even
+      // hidden ones
+      std::string id = get_desktop_id(dir, entry.path());
+      if (!seen_ids.insert(id).second)
+        continue;
+
+      this->add(id, entry.path());
+    }
+  }
+}
+
+DesktopIndex::DesktopIndex(std::vector<DesktopEntry> entries) {
+  this->entries.reserve(entries.size());
+  for (auto &entry : entries)
+    this->insert(std::move(entry));
+}
+
+void DesktopIndex::add(const std::string &id, const fs::path &path) {
+  auto desktop_entry = parse_desktop_file(path);
+  if (!desktop_entry || desktop_entry->no_display || desktop_entry->hidden)
+    return;
+
+  desktop_entry->id = id;
+  this->insert(std::move(*desktop_entry));
+}
+
+void DesktopIndex::insert(DesktopEntry entry) {
+  size_t index = this->entries.size();
+  this->by_name.emplace(to_lower(entry.name), index);
+  this->by_id.emplace(to_lower(entry.id), index);
+  this->by_id.emplace(to_lower(fs::path(entry.path).stem().string()), index);
+  this->entries.push_back(std::move(entry));
+}
+
+std::optional<DesktopEntry> DesktopIndex::find(const std::string &name) const {
+  std::string name_lower = to_lower(name);
+
+  auto it = this->by_name.find(name_lower);
+  if (it == this->by_name.end()) {
+    it = this->by_id.find(name_lower);
+    if (it == this->by_id.end())
+      return std::nullopt;
+  }
+
+  return this->entries[it->second];
+}
+
+std::vector<fs::path> get_application_dirs() {
+  std::vector<fs::path> app_dirs;
+  for (const auto &xdg_dir : get_xdg_data_dirs())
+    app_dirs.push_back(xdg_dir / "applications");
+
+  return app_dirs;
+}
+
+DesktopIndex build_desktop_index() {
+  return DesktopIndex{get_application_dirs()};
+}
+
+} // namespace hyprdock
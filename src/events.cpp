@@ -0,0 +1,156 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <optional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+#include "events.hpp"
+
+namespace hyprland::events {
+
+// Split event data into exactly `count` fields, the last field keeps any
+// remaining commas (window titles may contain them)
+static std::optional<std::vector<std::string>> split_args(std::string_view data,
+                                                          size_t count) {
+  std::vector<std::string> args;
+  args.reserve(count);
+
+  while (args.size() + 1 < count) {
+    size_t comma_pos = data.find(',');
+    if (comma_pos == std::string_view::npos)
+      return std::nullopt;
+
+    args.emplace_back(data.substr(0, comma_pos));
+    data.remove_prefix(comma_pos + 1);
+  }
+
+  args.emplace_back(data);
+  return args;
+}
+
+std::optional<Event> parse_event(std::string_view line) {
+  size_t sep_pos = line.find(">>");
+  if (sep_pos == std::string_view::npos)
+    return std::nullopt;
+
+  std::string_view name = line.substr(0, sep_pos);
+  std::string_view data = line.substr(sep_pos + 2);
+
+  EventType type;
+  size_t arg_count;
+  if (name == "workspace") {
+    type = EventType::Workspace;
+    arg_count = 1;
+  } else if (name == "openwindow") {
+    type = EventType::OpenWindow;
+    arg_count = 4;
+  } else if (name == "closewindow") {
+    type = EventType::CloseWindow;
+    arg_count = 1;
+  } else if (name == "movewindow") {
+    type = EventType::MoveWindow;
+    arg_count = 2;
+  } else if (name == "activewindow") {
+    type = EventType::ActiveWindow;
+    arg_count = 2;
+  } else {
+    return std::nullopt;
+  }
+
+  auto args = split_args(data, arg_count);
+  if (!args)
+    return std::nullopt;
+
+  return Event{.type = type, .args = std::move(*args)};
+}
+
+Listener::~Listener(void) {
+  this->disconnect();
+}
+
+bool Listener::connect(const std::string &sock_path) {
+  this->disconnect();
+
+  int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (sock < 0) {
+    std::println(std::cerr, "[ERROR] Failed to open event socket");
+    return false;
+  }
+
+  struct sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, sock_path.c_str(), sizeof(addr.sun_path) - 1);
+
+  if (::connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    std::println(std::cerr, "[ERROR] Failed to connect to event socket: {}",
+                 strerror(errno));
+    close(sock);
+    return false;
+  }
+
+  this->fd = sock;
+  return true;
+}
+
+void Listener::disconnect(void) {
+  if (this->fd >= 0)
+    close(this->fd);
+
+  this->fd = -1;
+  this->pending.clear();
+}
+
+std::vector<Event> Listener::read_events(void) {
+  std::vector<Event> events;
+  if (this->fd < 0)
+    return events;
+
+  bool closed = false;
+  char buffer[4096];
+  while (true) {
+    ssize_t bytes_read = recv(this->fd, buffer, sizeof(buffer), 0);
+    if (bytes_read > 0) {
+      this->pending.append(buffer, bytes_read);
+      continue;
+    }
+
+    if (bytes_read < 0 && errno == EINTR)
+      continue;
+
+    if (bytes_read == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+      closed = true;
+
+    break;
+  }
+
+  size_t start = 0;
+  size_t end = this->pending.find('\n');
+  while (end != std::string::npos) {
+    std::string_view line{this->pending.data() + start, end - start};
+    if (auto event = parse_event(line))
+      events.push_back(std::move(*event));
+
+    start = end + 1;
+    end = this->pending.find('\n', start);
+  }
+
+  this->pending.erase(0, start);
+
+  if (closed) {
+    std::println(std::cerr, "[ERROR] Event socket closed");
+    this->disconnect();
+  }
+
+  return events;
+}
+
+} // namespace hyprland::events
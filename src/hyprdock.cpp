@@ -1,20 +1,63 @@
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iostream>
+#include <optional>
 #include <print>
 #include <raylib.h>
+#include <rlgl.h>
+#include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "atlas.hpp"
+#include "cache.hpp"
 #include "commands.hpp"
 #include "config.hpp"
 #include "hyprdock.hpp"
 #include "ipc.hpp"
+#include "latency.hpp"
+#include "launcher.hpp"
 #include "utils.hpp"
+#include "worker.hpp"
+
+#ifdef PLATFORM_DESKTOP_GLFW
+// raylib bundles GLFW but does not expose a way to interrupt event waiting
+extern "C" void glfwPostEmptyEvent(void);
+#endif
 
 namespace hyprdock {
 
-State::State(void) {
-  this->config = hyprdock::load_config();
+// Only raylib's GLFW platform can be woken up by the IPC worker, every other
+// platform checks for snapshots every EVENT_POLL_INTERVAL instead
+void enable_event_waiting(void) {
+#ifdef PLATFORM_DESKTOP_GLFW
+  EnableEventWaiting();
+#else
+  DisableEventWaiting();
+#endif
+}
+
+void wait_for_events(void) {
+#ifdef PLATFORM_DESKTOP_GLFW
+  EnableEventWaiting();
+#else
+  DisableEventWaiting();
+  WaitTime(EVENT_POLL_INTERVAL);
+#endif
+  PollInputEvents();
+}
+
+State::State(const Options &options) : options(options) {
+  // Before raylib or the worker start any thread
+  block_child_signal();
+  block_report_signal();
+
+  auto start_time = std::chrono::steady_clock::now();
+  // Handed to the worker afterwards, taskbar apps are looked up in it
+  DesktopCache desktop_cache;
+  this->config = hyprdock::load_config(options, desktop_cache);
 
   auto sock_path = hyprland::IPC::get_socket_path();
   if (!sock_path) {
@@ -43,35 +86,28 @@ State::State(void) {
   }
 
   this->monitor = *it;
+  this->update_layout();
 
-  this->active_workspace = hyprland::command::get_active_workspace(*sock_path);
-
-  this->dock_width =
-      this->config.app_size * this->config.applications.size() +
-      this->config.app_padding * (this->config.applications.size() > 0
-                                      ? this->config.applications.size() - 1
-                                      : 0) +
-      this->config.dock_padding * 2;
-  this->dock_height =
-      this->config.app_size + this->config.dock_padding * 2 + 10;
-  this->window_x = (this->monitor.width - this->dock_width) / 2;
-  this->window_y =
-      this->monitor.height - this->dock_height - this->config.dock_margin;
-  this->fps = 30;
-
-  this->hover_area = Rectangle{
-      .x = static_cast<float>(this->window_x),
-      .y = static_cast<float>(this->window_y),
-      .width = static_cast<float>(this->dock_width),
-      .height =
-          static_cast<float>(this->dock_height + this->config.dock_margin),
-  };
+  // Icons are picked from the theme and resampled at the pixel size they are
+  // drawn at on this monitor, mipmaps keep them smooth while they are scaled
+  // down further
+  this->icon_size = static_cast<int>(
+      std::lround(this->config.app_size * this->monitor.scale));
+  for (auto &app : this->config.applications) {
+    if (app.icon.empty())
+      app.icon = desktop_cache.resolve_icon(app.icon_name, this->icon_size);
+  }
+  desktop_cache.save();
 
   this->uuid = "hyprdock-" + hyprdock::generate_id();
-  this->animations.resize(this->config.applications.size(), 0);
+  this->animations = Animator{
+      this->config.applications.size(),
+      Tween::Seconds{FADE_IN_TIME},
+      Tween::Seconds{FADE_OUT_TIME},
+  };
   this->active_cache.resize(this->config.applications.size(), false);
+  this->launching.resize(this->config.applications.size(), false);
 
-  this->last_command_time = std::chrono::steady_clock::now();
   this->start_wait_time = std::chrono::steady_clock::now();
 
   this->wait_mouse_pos = hyprland::command::get_mouse_position(*sock_path);
@@ -84,34 +120,297 @@ State::State(void) {
 
   this->wait_interval = std::chrono::milliseconds{this->config.wait_time};
 
-  SetConfigFlags(FLAG_WINDOW_UNDECORATED);
+  // The hidden dock is drawn as a fully transparent trigger strip
+  if (this->config.edge_trigger)
+    SetConfigFlags(FLAG_WINDOW_UNDECORATED | FLAG_WINDOW_TRANSPARENT);
+  else
+    SetConfigFlags(FLAG_WINDOW_UNDECORATED);
 
   InitWindow(this->dock_width, this->dock_height, this->uuid.c_str());
 
   SetWindowMonitor(this->monitor.id);
 
+  // Fades are time based, frames only pace how smooth they look
+  int refresh_rate = GetMonitorRefreshRate(this->monitor.id);
+  this->fps = refresh_rate > 0 ? refresh_rate : 60;
+
   SetWindowPosition(this->window_x, this->window_y);
   // SetTargetFPS(this->fps);
   SetExitKey(0); // Disable default exit key
 
-  for (const auto &app : this->config.applications) {
-    if (this->app_icons.contains(app.name))
-      continue;
+  // Overlays and dots sample the white block of the atlas, so icons and
+  // shapes never switch textures in between
+  if (this->atlas.build(this->config.applications, this->icon_size,
+                        this->pixel_cache))
+    SetShapesTexture(this->atlas.get_texture(), this->atlas.get_white_rect());
+  // Taskbar icons are only loaded later on, the cache is written at exit so
+  // it keeps them for the next run
+  if (!this->config.taskbar)
+    this->pixel_cache.save();
+
+  this->load_static_layer();
+
+  if (this->options.stats)
+    std::println("[STATS] Icon atlas: {} apps at {}x{} px, {}x{} texture, "
+                 "{:.1f} KiB",
+                 this->config.applications.size(), this->icon_size,
+                 this->icon_size,
+                 this->atlas.get_texture().width,
+                 this->atlas.get_texture().height,
+                 this->atlas.get_memory_size() / 1024.0);
+
+  hyprland::IPC::Batch batch;
+  hyprland::command::set_plain_window(this->uuid, batch);
+  hyprland::command::set_unmoveable_window(this->uuid, batch);
+  // The dock still works without its window rules, it just looks off
+  auto rules_resp = batch.send(*sock_path);
+  if (!rules_resp)
+    std::println(std::cerr, "[ERROR] Failed to set window rules: {}",
+                 rules_resp.error());
+
+  enable_event_waiting();
+
+  // Wake the render loop out of event waiting whenever the worker publishes
+  if (!this->worker.start({
+          .sock_path = *sock_path,
+          .uuid = this->uuid,
+          .apps = this->config.applications,
+          .hover_area = this->hover_area,
+          .visible = !this->is_minimized,
+          .edge_trigger = this->config.edge_trigger,
+          .launch_backend = this->config.launch_backend,
+          .taskbar = this->config.taskbar,
+          .icon_size = this->icon_size,
+          .desktop_cache = this->config.taskbar
+                               ? std::optional{std::move(desktop_cache)}
+                               : std::nullopt,
+          .print_stats = this->options.stats,
+#ifdef PLATFORM_DESKTOP_GLFW
+          .on_publish = [] { glfwPostEmptyEvent(); },
+#endif
+      }))
+    this->error = true;
+
+  if (this->options.timing) {
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start_time;
+    std::println("[TIMING] Startup took {:.2f} ms", elapsed.count());
+  }
+}
+
+void State::reveal(void) {
+  this->worker.send({
+      .type = RequestType::Reveal,
+      .mouse_pos = this->mouse_pos,
+  });
+
+  if (this->config.edge_trigger)
+    SetWindowSize(this->dock_width, this->dock_height);
+  SetWindowPosition(this->window_x, this->window_y);
+
+  this->is_minimized = false;
+  this->waiting = false;
+  this->dirty = true;
+}
+
+void State::hide(void) {
+  this->worker.send({
+      .type = RequestType::Hide,
+      .mouse_pos = this->mouse_pos,
+  });
+
+  if (this->config.edge_trigger) {
+    SetWindowSize(this->dock_width, TRIGGER_HEIGHT);
+    SetWindowPosition(this->window_x, this->monitor.height - TRIGGER_HEIGHT);
+  } else {
+    SetWindowPosition(this->window_x, this->window_y);
+  }
+
+  this->is_minimized = true;
+  // Deselect app if the window gets hidden
+  this->clicked_app = -1;
+  this->dirty = true;
+}
+
+void State::apply_snapshot(IpcSnapshot snapshot) {
+  this->mouse_pos = snapshot.mouse_pos;
+
+  // The list is only replaced when an app came or went, so comparing the
+  // pointer skips the diff for every other window event
+  if (snapshot.taskbar && snapshot.taskbar != this->taskbar) {
+    this->taskbar = std::move(snapshot.taskbar);
+    this->update_taskbar(*this->taskbar);
+  }
+
+  if (snapshot.running != this->active_cache) {
+    this->active_cache = std::move(snapshot.running);
+    this->layer_dirty = true;
+    this->dirty = true;
+  }
+
+  if (snapshot.launching != this->launching) {
+    this->launching = std::move(snapshot.launching);
+    this->dirty = true;
+  }
+}
+
+void State::update_taskbar(const std::vector<DesktopEntry> &apps) {
+  size_t pinned = this->config.applications.size();
+  auto erase_slot = [&](size_t index) {
+    this->atlas.erase(pinned + index);
+    this->animations.erase(pinned + index);
+    this->taskbar_apps.erase(this->taskbar_apps.begin() + index);
+  };
+
+  std::unordered_set<std::string> ids;
+  for (const auto &app : apps)
+    ids.insert(app.id);
+
+  // Closed apps give up their slot, the others keep their cell and fade
+  size_t old_size = this->taskbar_apps.size();
+  for (size_t i = this->taskbar_apps.size(); i-- > 0;) {
+    if (!ids.contains(this->taskbar_apps[i].id))
+      erase_slot(i);
+  }
+
+  // The worker never reorders apps, one out of place was closed and opened
+  // again in between two snapshots and gets a new slot at the end
+  size_t kept = 0;
+  while (kept < this->taskbar_apps.size() && kept < apps.size() &&
+         this->taskbar_apps[kept].id == apps[kept].id)
+    kept++;
+  while (this->taskbar_apps.size() > kept)
+    erase_slot(this->taskbar_apps.size() - 1);
+
+  // Only the apps that showed up load an icon
+  for (size_t i = kept; i < apps.size(); i++) {
+    this->atlas.push(apps[i], this->pixel_cache);
+    this->animations.push();
+    this->taskbar_apps.push_back(apps[i]);
+  }
+
+  if (kept == old_size && kept == apps.size())
+    return;
+
+  // A full atlas is replaced by a larger texture
+  SetShapesTexture(this->atlas.get_texture(), this->atlas.get_white_rect());
+  this->relayout();
+}
+
+void State::update_layout(void) {
+  size_t app_count = this->get_app_count();
+  this->dock_width = this->config.app_size * app_count +
+                     this->config.app_padding *
+                         (app_count > 0 ? app_count - 1 : 0) +
+                     this->config.dock_padding * 2;
+  this->dock_height =
+      this->config.app_size + this->config.dock_padding * 2 + 10;
+  this->window_x = (this->monitor.width - this->dock_width) / 2;
+  this->window_y =
+      this->monitor.height - this->dock_height - this->config.dock_margin;
+
+  this->hover_area = Rectangle{
+      .x = static_cast<float>(this->window_x),
+      .y = static_cast<float>(this->window_y),
+      .width = static_cast<float>(this->dock_width),
+      .height =
+          static_cast<float>(this->dock_height + this->config.dock_margin),
+  };
+}
+
+void State::relayout(void) {
+  this->update_layout();
+
+  // The static layer always matches the window size
+  UnloadRenderTexture(this->static_layer);
+  this->load_static_layer();
+
+  if (this->is_minimized && this->config.edge_trigger) {
+    SetWindowSize(this->dock_width, TRIGGER_HEIGHT);
+    SetWindowPosition(this->window_x, this->monitor.height - TRIGGER_HEIGHT);
+  } else {
+    SetWindowSize(this->dock_width, this->dock_height);
+    SetWindowPosition(this->window_x, this->window_y);
+  }
+
+  this->worker.send({
+      .type = RequestType::Resize,
+      .mouse_pos = this->mouse_pos,
+      .hover_area = this->hover_area,
+  });
 
-    Texture2D icon = LoadTexture(app.icon.c_str());
-    if (icon.id == 0)
-      std::println("[WARNING] Failed to load icon for {} from {}", app.name,
-                   app.icon);
-    this->app_icons[app.name] = icon;
+  // Slots after a removed app moved, a press no longer points at its app
+  this->clicked_app = -1;
+  this->layer_dirty = true;
+  this->dirty = true;
+}
+
+void State::load_static_layer(void) {
+  // Scaled icons would be shrunk back to 1x in a layer of the logical size
+  float scale = this->get_layer_scale();
+  this->static_layer = LoadRenderTexture(
+      static_cast<int>(std::lround(this->dock_width * scale)),
+      static_cast<int>(std::lround(this->dock_height * scale)));
+  SetTextureFilter(this->static_layer.texture, TEXTURE_FILTER_BILINEAR);
+}
+
+void State::render_static_layer(void) {
+  BeginTextureMode(this->static_layer);
+  ClearBackground(this->config.dock_color);
+
+  // Color blends as usual but alpha only accumulates, so the layer stays as
+  // opaque as the background under antialiased icon edges and the blit does
+  // not mix the background in a second time
+  rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE,
+                            RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+  BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+  BeginMode2D(Camera2D{
+      .offset = Vector2{0, 0},
+      .target = Vector2{0, 0},
+      .rotation = 0.0f,
+      .zoom = this->get_layer_scale(),
+  });
+
+  for (size_t i = 0; i < this->get_app_count(); i++) {
+    this->draw_icon(static_cast<int>(i));
+
+    // Draw active dot
+    if (this->active_cache[i]) {
+      Rectangle app_rect = this->get_app_rect(static_cast<int>(i));
+      DrawCircle(app_rect.x + app_rect.width / 2,
+                 app_rect.y + app_rect.height + this->config.dock_padding - 5,
+                 3, Color{0, 182, 255, 255});
+    }
   }
 
-  hyprland::command::set_plain_window(this->uuid, *sock_path);
-  hyprland::command::set_unmoveable_window(this->uuid, *sock_path);
+  EndMode2D();
+  EndBlendMode();
+  EndTextureMode();
+  this->layer_dirty = false;
+}
+
+void State::draw_icon(int index) {
+  // Missing icons get the "?" glyph over the whole slot
+  Rectangle app_rect = this->get_app_rect(index);
+  Rectangle icon_rect{
+      app_rect.x + 2,
+      app_rect.y + 2,
+      app_rect.width - 4,
+      app_rect.height - 4,
+  };
+
+  DrawTexturePro(this->atlas.get_texture(), this->atlas.get_slot(index),
+                 this->atlas.has_icon(index) ? icon_rect : app_rect,
+                 Vector2{0, 0}, 0.0f, WHITE);
 }
 
 void State::unload(void) {
-  for (const auto &texture : this->app_icons)
-    UnloadTexture(texture.second);
+  this->worker.stop();
+  if (this->config.taskbar)
+    this->pixel_cache.save();
+
+  this->atlas.unload();
+  UnloadRenderTexture(this->static_layer);
 }
 
 } // namespace hyprdock
@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "icons.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+namespace hyprdock {
+
+using IniSection = std::unordered_map<std::string, std::string>;
+using IniFile = std::unordered_map<std::string, IniSection>;
+
+static IniFile parse_ini_file(const fs::path &path) {
+  IniFile ini;
+  std::ifstream file{path};
+  if (!file.is_open())
+    return ini;
+
+  std::string line;
+  std::string section;
+  while (std::getline(file, line)) {
+    line = trim(line);
+
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    if (line[0] == '[' && line.back() == ']') {
+      section = line.substr(1, line.size() - 2);
+      continue;
+    }
+
+    size_t eq_pos = line.find('=');
+    if (eq_pos != std::string::npos)
+      ini[section][trim(line.substr(0, eq_pos))] =
+          trim(line.substr(eq_pos + 1));
+  }
+
+  return ini;
+}
+
+static std::vector<std::string> split_list(const std::string &str) {
+  std::vector<std::string> items;
+  size_t start = 0;
+  while (start <= str.size()) {
+    size_t end = str.find(',', start);
+    if (end == std::string::npos)
+      end = str.size();
+
+    std::string item = trim(str.substr(start, end - start));
+    if (!item.empty())
+      items.push_back(item);
+
+    start = end + 1;
+  }
+
+  return items;
+}
+
+static int get_int(const IniSection &keys, const std::string &key,
+                   int fallback) {
+  auto it = keys.find(key);
+  if (it == keys.end())
+    return fallback;
+
+  char *end = nullptr;
+  long value = std::strtol(it->second.c_str(), &end, 10);
+  return end == it->second.c_str() ? fallback : static_cast<int>(value);
+}
+
+bool IconDirectory::matches_size(int icon_size, int icon_scale) const {
+  if (this->scale != icon_scale)
+    return false;
+
+  switch (this->type) {
+  case IconDirType::Fixed:
+    return this->size == icon_size;
+  case IconDirType::Scalable:
+    return this->min_size <= icon_size && icon_size <= this->max_size;
+  case IconDirType::Threshold:
+    return this->size - this->threshold <= icon_size &&
+           icon_size <= this->size + this->threshold;
+  }
+
+  return false;
+}
+
+int IconDirectory::size_distance(int icon_size, int icon_scale) const {
+  int scaled = icon_size * icon_scale;
+
+  switch (this->type) {
+  case IconDirType::Fixed:
+    return std::abs(this->size * this->scale - scaled);
+  case IconDirType::Scalable:
+    if (scaled < this->min_size * this->scale)
+      return this->min_size * this->scale - scaled;
+    if (scaled > this->max_size * this->scale)
+      return scaled - this->max_size * this->scale;
+    return 0;
+  case IconDirType::Threshold:
+    if (scaled < (this->size - this->threshold) * this->scale)
+      return this->min_size * this->scale - scaled;
+    if (scaled > (this->size + this->threshold) * this->scale)
+      return scaled - this->max_size * this->scale;
+    return 0;
+  }
+
+  return INT_MAX;
+}
+
+IconLookup::IconLookup(const std::string &theme_name,
+                       const std::vector<fs::path> &base_dirs) {
+  // Walk the Inherits= chain depth first, hicolor always comes last
+  this->scanned_dirs = base_dirs;
+
+  std::vector<std::string> pending{theme_name};
+  std::unordered_set<std::string> visited;
+
+  while (!pending.empty()) {
+    std::string name = pending.back();
+    pending.pop_back();
+
+    if (name == "hicolor" || !visited.insert(name).second)
+      continue;
+
+    if (!this->load_theme(name, base_dirs))
+      continue;
+
+    const auto &inherits = this->chain.back().inherits;
+    pending.insert(pending.end(), inherits.rbegin(), inherits.rend());
+  }
+
+  this->load_theme("hicolor", base_dirs);
+
+  // raylib can only decode PNG, so SVG and XPM files are not indexed
+  this->scanned_dirs.push_back("/usr/share/pixmaps");
+  std::error_code ec;
+  for (const auto &entry :
+       fs::directory_iterator("/usr/share/pixmaps", ec)) {
+    if (entry.path().extension() == ".png")
+      this->pixmaps.emplace(entry.path().stem().string(), entry.path());
+  }
+}
+
+bool IconLookup::load_theme(const std::string &theme_name,
+                            const std::vector<fs::path> &base_dirs) {
+  // index.theme comes from the first base directory that has one, icons
+  // from every base directory that contains the theme
+  std::vector<fs::path> theme_dirs;
+  IniFile index;
+  for (const auto &base_dir : base_dirs) {
+    fs::path theme_dir = base_dir / theme_name;
+    std::error_code ec;
+    if (!fs::is_directory(theme_dir, ec))
+      continue;
+
+    theme_dirs.push_back(theme_dir);
+    this->scanned_dirs.push_back(theme_dir);
+    if (index.empty())
+      index = parse_ini_file(theme_dir / "index.theme");
+  }
+
+  auto section = index.find("Icon Theme");
+  if (section == index.end())
+    return false;
+
+  IconTheme theme;
+  theme.name = theme_name;
+  theme.inherits = split_list(section->second["Inherits"]);
+
+  std::vector<std::string> dir_names =
+      split_list(section->second["Directories"]);
+  for (const auto &dir_name :
+       split_list(section->second["ScaledDirectories"]))
+    dir_names.push_back(dir_name);
+
+  for (const auto &dir_name : dir_names) {
+    auto dir_section = index.find(dir_name);
+    if (dir_section == index.end())
+      continue;
+
+    const auto &keys = dir_section->second;
+    IconDirectory directory;
+    directory.path = dir_name;
+    directory.size = get_int(keys, "Size", 0);
+    directory.scale = get_int(keys, "Scale", 1);
+    directory.min_size = get_int(keys, "MinSize", directory.size);
+    directory.max_size = get_int(keys, "MaxSize", directory.size);
+    directory.threshold = get_int(keys, "Threshold", 2);
+
+    auto type = keys.find("Type");
+    if (type != keys.end() && type->second == "Fixed")
+      directory.type = IconDirType::Fixed;
+    else if (type != keys.end() && type->second == "Scalable")
+      directory.type = IconDirType::Scalable;
+
+    size_t dir_index = theme.directories.size();
+    theme.directories.push_back(directory);
+
+    // One listing per directory replaces a stat per icon and size
+    for (const auto &theme_dir : theme_dirs) {
+      this->scanned_dirs.push_back(theme_dir / dir_name);
+      std::error_code ec;
+      for (const auto &entry :
+           fs::directory_iterator(theme_dir / dir_name, ec)) {
+        if (entry.path().extension() == ".png")
+          theme.icons[entry.path().stem().string()].push_back(
+              {.directory = dir_index, .path = entry.path()});
+      }
+    }
+  }
+
+  this->chain.push_back(std::move(theme));
+  return true;
+}
+
+std::string IconLookup::find(const std::string &icon_name, int size,
+                             int scale) const {
+  for (const auto &theme : this->chain) {
+    auto it = theme.icons.find(icon_name);
+    if (it == theme.icons.end())
+      continue;
+
+    const fs::path *closest = nullptr;
+    int min_distance = std::numeric_limits<int>::max();
+    for (const auto &candidate : it->second) {
+      const auto &directory = theme.directories[candidate.directory];
+      if (directory.matches_size(size, scale))
+        return candidate.path.string();
+
+      int distance = directory.size_distance(size, scale);
+      if (distance < min_distance) {
+        min_distance = distance;
+        closest = &candidate.path;
+      }
+    }
+
+    if (closest)
+      return closest->string();
+  }
+
+  auto pixmap = this->pixmaps.find(icon_name);
+  if (pixmap != this->pixmaps.end())
+    return pixmap->second.string();
+
+  return "";
+}
+
+std::vector<fs::path> get_icon_base_dirs() {
+  std::vector<fs::path> base_dirs;
+
+  const char *home_dir = std::getenv("HOME");
+  if (home_dir && std::strlen(home_dir) > 0)
+    base_dirs.push_back(fs::path(home_dir) / ".icons");
+
+  for (const auto &xdg_dir : get_xdg_data_dirs())
+    base_dirs.push_back(xdg_dir / "icons");
+
+  return base_dirs;
+}
+
+std::string get_user_icon_theme() {
+  fs::path config_dir;
+  const char *xdg_config_home = std::getenv("XDG_CONFIG_HOME");
+  const char *home_dir = std::getenv("HOME");
+  if (xdg_config_home && std::strlen(xdg_config_home) > 0)
+    config_dir = xdg_config_home;
+  else if (home_dir && std::strlen(home_dir) > 0)
+    config_dir = fs::path(home_dir) / ".config";
+  else
+    return "Adwaita";
+
+  for (const char *gtk_dir : {"gtk-4.0", "gtk-3.0"}) {
+    IniFile settings = parse_ini_file(config_dir / gtk_dir / "settings.ini");
+    auto section = settings.find("Settings");
+    if (section == settings.end())
+      continue;
+
+    auto theme = section->second.find("gtk-icon-theme-name");
+    if (theme != section->second.end() && !theme->second.empty())
+      return theme->second;
+  }
+
+  // Same default GTK falls back to when no theme is configured
+  return "Adwaita";
+}
+
+const IconLookup &get_icon_lookup() {
+  static const IconLookup lookup{get_user_icon_theme(), get_icon_base_dirs()};
+  return lookup;
+}
+
+} // namespace hyprdock
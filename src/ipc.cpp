@@ -1,12 +1,16 @@
+#include <cerrno>
+#include <cstddef>
 #include <cstdlib>
 #include <cstring>
 #include <expected>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/un.h>
 #include <unistd.h>
+#include <utility>
 #include <vector>
 
 #include "ipc.hpp"
@@ -40,9 +44,22 @@ std::optional<std::string> get_socket_path() {
   return *runtime_dir + "/hypr/" + *instance_signature + "/.socket.sock";
 }
 
-std::expected<std::string, std::string>
+std::optional<std::string> get_event_socket_path() {
+  auto runtime_dir = get_runtime_dir();
+  auto instance_signature = get_instance_signature();
+
+  if (!runtime_dir || !instance_signature)
+    return std::nullopt;
+
+  return *runtime_dir + "/hypr/" + *instance_signature + "/.socket2.sock";
+}
+
+std::expected<std::string_view, std::string>
 send_command(const std::string &command, const std::string &sock_path) {
-  int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  // Grows to fit the largest reply seen so far and is never shrunk
+  thread_local std::vector<char> buffer(4096);
+
+  int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
   if (sock < 0)
     return std::unexpected{"Failed to open socket"};
 
@@ -56,20 +73,100 @@ send_command(const std::string &command, const std::string &sock_path) {
     return std::unexpected{"Failed to connect to socket"};
   }
 
-  if (send(sock, command.c_str(), command.length(), 0) < 0) {
-    close(sock);
-    return std::unexpected{"Failed to send command"};
+  size_t bytes_sent = 0;
+  while (bytes_sent < command.length()) {
+    ssize_t sent = send(sock, command.data() + bytes_sent,
+                        command.length() - bytes_sent, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR)
+        continue;
+
+      close(sock);
+      return std::unexpected{"Failed to send command"};
+    }
+
+    bytes_sent += sent;
+  }
+
+  // Hyprland closes the connection once the whole reply has been written
+  size_t length = 0;
+  while (true) {
+    if (length == buffer.size())
+      buffer.resize(buffer.size() * 2);
+
+    ssize_t bytes_read =
+        recv(sock, buffer.data() + length, buffer.size() - length, 0);
+    if (bytes_read < 0) {
+      if (errno == EINTR)
+        continue;
+
+      close(sock);
+      return std::unexpected{"Failed to read from socket"};
+    }
+
+    if (bytes_read == 0)
+      break;
+
+    length += bytes_read;
   }
 
-  std::vector<char> buffer(4096);
-  ssize_t bytes_read = recv(sock, buffer.data(), buffer.size() - 1, 0);
   close(sock);
+  return std::string_view{buffer.data(), length};
+}
+
+Batch &Batch::dispatch(const std::string &args) {
+  this->commands.push_back("dispatch " + args);
+  return *this;
+}
+
+Batch &Batch::keyword(const std::string &args) {
+  this->commands.push_back("keyword " + args);
+  return *this;
+}
 
-  if (bytes_read < 0)
-    return std::unexpected{"Failed to read from socket"};
+// Hyprland splits [[BATCH]] requests at every ';', so a command containing
+// one has to be sent in a request of its own
+static bool is_batchable(const std::string &command) {
+  return command.find(';') == std::string::npos;
+}
+
+static std::string build_request(const std::vector<std::string> &commands,
+                                 size_t begin, size_t end) {
+  if (end - begin == 1)
+    return commands[begin];
+
+  std::string request = "[[BATCH]]";
+  for (size_t i = begin; i < end; i++) {
+    if (i > begin)
+      request += ';';
+    request += commands[i];
+  }
+
+  return request;
+}
+
+std::expected<std::string_view, std::string>
+Batch::send(const std::string &sock_path) {
+  std::vector<std::string> commands = std::exchange(this->commands, {});
+  std::expected<std::string_view, std::string> resp = std::string_view{};
+
+  // Commands keep their order, every run of batchable ones is one request
+  size_t begin = 0;
+  while (begin < commands.size()) {
+    size_t end = begin + 1;
+    if (is_batchable(commands[begin])) {
+      while (end < commands.size() && is_batchable(commands[end]))
+        end++;
+    }
+
+    resp = send_command(build_request(commands, begin, end), sock_path);
+    if (!resp)
+      return resp;
+
+    begin = end;
+  }
 
-  buffer[bytes_read] = '\0';
-  return std::string{buffer.data()};
+  return resp;
 }
 
 } // namespace hyprland::IPC
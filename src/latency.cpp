@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstddef>
+#include <optional>
+#include <print>
+#include <pthread.h>
+#include <vector>
+
+#include "commands.hpp"
+#include "latency.hpp"
+#include "utils.hpp"
+
+namespace hyprdock {
+
+void block_report_signal(void) {
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGUSR1);
+  pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+}
+
+// Nearest-rank percentile of sorted samples
+static double get_percentile(const std::vector<double> &sorted,
+                             double percentile) {
+  auto rank =
+      static_cast<size_t>(std::ceil(percentile / 100.0 * sorted.size()));
+  return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+void LaunchTracker::resize(size_t apps) {
+  this->samples.resize(apps);
+}
+
+void LaunchTracker::start(size_t app, std::optional<pid_t> pid,
+                          Clock::time_point now) {
+  // Clicking again while launching keeps the first timestamp
+  for (const auto &launch : this->pending) {
+    if (launch.app == app)
+      return;
+  }
+
+  this->pending.push_back({.app = app, .pid = pid, .start = now});
+}
+
+bool LaunchTracker::match(const ClientSnapshot &clients,
+                          const std::vector<bool> &running,
+                          Clock::time_point now) {
+  // Apps are only launched when they have no window, so any window of the
+  // app showing up afterwards is the launched one
+  auto matched = std::remove_if(
+      this->pending.begin(), this->pending.end(), [&](const Launch &launch) {
+        bool found = (launch.pid && clients.find_by_pid(*launch.pid)) ||
+                     (launch.app < running.size() && running[launch.app]);
+        if (found && launch.app < this->samples.size())
+          this->samples[launch.app].push_back(
+              std::chrono::duration<double, std::milli>(now - launch.start)
+                  .count());
+        return found;
+      });
+
+  bool changed = matched != this->pending.end();
+  this->pending.erase(matched, this->pending.end());
+  return changed;
+}
+
+bool LaunchTracker::expire(Clock::time_point now) {
+  size_t count = std::erase_if(this->pending, [&](const Launch &launch) {
+    return now - launch.start >= this->timeout;
+  });
+
+  this->expired += count;
+  return count > 0;
+}
+
+std::vector<bool> LaunchTracker::get_pending(void) const {
+  std::vector<bool> pending(this->samples.size(), false);
+  for (const auto &launch : this->pending) {
+    if (launch.app < pending.size())
+      pending[launch.app] = true;
+  }
+
+  return pending;
+}
+
+std::optional<LaunchTracker::Clock::time_point>
+LaunchTracker::next_expiry(void) const {
+  std::optional<Clock::time_point> expiry;
+  for (const auto &launch : this->pending) {
+    if (!expiry || launch.start + this->timeout < *expiry)
+      expiry = launch.start + this->timeout;
+  }
+
+  return expiry;
+}
+
+bool LaunchTracker::has_samples(void) const {
+  return this->expired > 0 ||
+         std::any_of(this->samples.begin(), this->samples.end(),
+                     [](const auto &samples) { return !samples.empty(); });
+}
+
+void LaunchTracker::print(const std::vector<DesktopEntry> &apps) const {
+  std::println("[STATS] Launch to first window latency:");
+  for (size_t i = 0; i < this->samples.size() && i < apps.size(); i++) {
+    if (this->samples[i].empty())
+      continue;
+
+    std::vector<double> sorted = this->samples[i];
+    std::sort(sorted.begin(), sorted.end());
+    std::println("[STATS]   {}: {} launches, p50 {:.0f} ms, p95 {:.0f} ms, "
+                 "max {:.0f} ms",
+                 apps[i].name, sorted.size(), get_percentile(sorted, 50),
+                 get_percentile(sorted, 95), sorted.back());
+  }
+
+  if (this->expired > 0)
+    std::println("[STATS]   {} launches opened no window within {} s",
+                 this->expired, this->timeout.count());
+}
+
+} // namespace hyprdock
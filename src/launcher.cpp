@@ -0,0 +1,284 @@
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <print>
+#include <pthread.h>
+#include <spawn.h>
+#include <string>
+#include <string_view>
+#include <sys/signalfd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "launcher.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+extern char **environ;
+
+namespace hyprdock {
+
+void block_child_signal(void) {
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGCHLD);
+  pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+}
+
+// Splits an Exec value into arguments. The value level escapes (\s, \n, \t,
+// \r, \\) are resolved first, then double quoted arguments where \", \`, \$
+// and \\ are escaped. Quoted arguments are flagged since field codes are
+// not expanded inside them.
+static std::vector<std::pair<std::string, bool>>
+split_exec(std::string_view exec) {
+  std::string value;
+  for (size_t i = 0; i < exec.size(); i++) {
+    if (exec[i] != '\\' || i + 1 == exec.size()) {
+      value += exec[i];
+      continue;
+    }
+
+    switch (exec[++i]) {
+    case 's':
+      value += ' ';
+      break;
+    case 'n':
+      value += '\n';
+      break;
+    case 't':
+      value += '\t';
+      break;
+    case 'r':
+      value += '\r';
+      break;
+    case '\\':
+      value += '\\';
+      break;
+    default:
+      value += '\\';
+      value += exec[i];
+    }
+  }
+
+  std::vector<std::pair<std::string, bool>> args;
+  std::string arg;
+  bool in_arg = false;
+  bool quoted = false;
+  bool in_quotes = false;
+  for (size_t i = 0; i < value.size(); i++) {
+    char c = value[i];
+
+    if (in_quotes) {
+      if (c == '\\' && i + 1 < value.size() &&
+          std::strchr("\"`$\\", value[i + 1])) {
+        arg += value[++i];
+      } else if (c == '"') {
+        in_quotes = false;
+      } else {
+        arg += c;
+      }
+    } else if (c == '"') {
+      in_arg = true;
+      quoted = true;
+      in_quotes = true;
+    } else if (c == ' ' || c == '\t' || c == '\n') {
+      if (in_arg)
+        args.emplace_back(std::move(arg), quoted);
+
+      arg.clear();
+      in_arg = false;
+      quoted = false;
+    } else {
+      in_arg = true;
+      arg += c;
+    }
+  }
+
+  if (in_arg)
+    args.emplace_back(std::move(arg), quoted);
+
+  return args;
+}
+
+std::vector<std::string> expand_exec(const DesktopEntry &app) {
+  std::vector<std::string> args;
+  for (auto &[arg, quoted] : split_exec(app.exec)) {
+    if (quoted) {
+      args.push_back(std::move(arg));
+      continue;
+    }
+
+    // %i expands to two arguments, or none without an icon
+    if (arg == "%i") {
+      if (!app.icon_name.empty()) {
+        args.push_back("--icon");
+        args.push_back(app.icon_name);
+      }
+      continue;
+    }
+
+    // Nothing is opened from the dock, so file and URL codes drop out along
+    // with the deprecated ones
+    std::string expanded;
+    bool had_code = false;
+    for (size_t i = 0; i < arg.size(); i++) {
+      if (arg[i] != '%' || i + 1 == arg.size()) {
+        expanded += arg[i];
+        continue;
+      }
+
+      had_code = true;
+      switch (arg[++i]) {
+      case '%':
+        expanded += '%';
+        break;
+      case 'c':
+        expanded += app.name;
+        break;
+      case 'k':
+        expanded += app.path;
+        break;
+      default:
+        break;
+      }
+    }
+
+    if (!had_code || !expanded.empty())
+      args.push_back(std::move(expanded));
+  }
+
+  return args;
+}
+
+std::string get_exec_name(const std::string &exec) {
+  auto args = split_exec(exec);
+  if (args.empty())
+    return "";
+
+  return fs::path{args.front().first}.filename().string();
+}
+
+std::string join_shell_command(const std::vector<std::string> &args) {
+  std::string command;
+  for (const auto &arg : args) {
+    if (!command.empty())
+      command += ' ';
+
+    bool safe = !arg.empty() &&
+                arg.find_first_not_of("abcdefghijklmnopqrstuvwxyz"
+                                      "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                      "0123456789_-+=/.,:@%") ==
+                    std::string::npos;
+    if (safe) {
+      command += arg;
+      continue;
+    }
+
+    command += '\'';
+    for (char c : arg) {
+      if (c == '\'')
+        command += "'\\''";
+      else
+        command += c;
+    }
+    command += '\'';
+  }
+
+  return command;
+}
+
+Launcher::~Launcher(void) {
+  this->stop();
+}
+
+bool Launcher::start(void) {
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGCHLD);
+
+  this->signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (this->signal_fd < 0) {
+    std::println(std::cerr, "[ERROR] Failed to create child reaper fd");
+    return false;
+  }
+
+  // Children may have exited before the fd existed
+  this->reap();
+  return true;
+}
+
+void Launcher::stop(void) {
+  if (this->signal_fd >= 0)
+    close(this->signal_fd);
+
+  this->signal_fd = -1;
+}
+
+std::optional<pid_t> Launcher::spawn(const DesktopEntry &app) {
+  auto args = expand_exec(app);
+  if (args.empty()) {
+    std::println(std::cerr, "[ERROR] Empty command for app {}", app.name);
+    return std::nullopt;
+  }
+
+  std::vector<char *> argv;
+  for (auto &arg : args)
+    argv.push_back(arg.data());
+  argv.push_back(nullptr);
+
+  // The child must not inherit the blocked SIGCHLD or ignored signals
+  sigset_t empty_mask;
+  sigemptyset(&empty_mask);
+  sigset_t default_signals;
+  sigemptyset(&default_signals);
+  sigaddset(&default_signals, SIGCHLD);
+  sigaddset(&default_signals, SIGPIPE);
+
+  short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+#ifdef POSIX_SPAWN_SETSID
+  // Own session, apps outlive the dock and never see its terminal signals
+  flags |= POSIX_SPAWN_SETSID;
+#endif
+
+  posix_spawnattr_t attr;
+  posix_spawnattr_init(&attr);
+  posix_spawnattr_setsigmask(&attr, &empty_mask);
+  posix_spawnattr_setsigdefault(&attr, &default_signals);
+  posix_spawnattr_setflags(&attr, flags);
+
+  // glibc spawns with vfork semantics, nothing of the dock's address space
+  // is copied and every dock fd is close-on-exec
+  pid_t pid;
+  int err = posix_spawnp(&pid, argv[0], nullptr, &attr, argv.data(), environ);
+  posix_spawnattr_destroy(&attr);
+
+  if (err != 0) {
+    std::println(std::cerr, "[ERROR] Failed to launch {}: {}", app.name,
+                 std::strerror(err));
+    return std::nullopt;
+  }
+
+  std::println("[INFO] Launched app {} with pid {}", app.name, pid);
+  return pid;
+}
+
+void Launcher::reap(void) {
+  if (this->signal_fd >= 0) {
+    struct signalfd_siginfo info;
+    while (read(this->signal_fd, &info, sizeof(info)) == sizeof(info))
+      ;
+  }
+
+  // Signals coalesce, so collect every exited child not just one per read
+  while (waitpid(-1, nullptr, WNOHANG) > 0)
+    ;
+}
+
+} // namespace hyprdock
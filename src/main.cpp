@@ -1,30 +1,45 @@
-#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <numbers>
+#include <print>
 #include <raylib.h>
-#include <string>
 #include <unistd.h>
+#include <utility>
 
-#include "commands.hpp"
 #include "hyprdock.hpp"
-#include "utils.hpp"
+#include "worker.hpp"
 
 #define FPS(fps) (1.0f / fps)
 
 #define OVERLAY_OPACITY 50
 
-#define FADE_IN_TIME 0.3
-#define FADE_OUT_TIME 0.2
+// Seconds per pulse of the dot of an app waiting for its first window
+#define LAUNCH_PULSE_PERIOD 1.0
+// Frames per second drawn while nothing but a launch dot moves
+#define LAUNCH_PULSE_FPS 10
 
-#define FADE_IN(fps) static_cast<int>(OVERLAY_OPACITY / (fps * FADE_IN_TIME))
-#define FADE_OUT(fps) static_cast<int>(OVERLAY_OPACITY / (fps * FADE_OUT_TIME))
+// Estimate of the draw calls in a frame, counted as texture switches in draw
+// order. rlgl also splits a batch on draw mode changes and when its buffer
+// fills up, neither is seen here, so the real count can be higher.
+struct DrawCounter {
+  long texture = 0;
+  int calls = 0;
 
-int main(void) {
-  hyprdock::State state;
+  inline void use(long id) {
+    if (this->calls == 0 || id != this->texture)
+      this->calls++;
+    this->texture = id;
+  }
+};
+
+int main(int argc, char **argv) {
+  hyprdock::State state{hyprdock::parse_options(argc, argv)};
   if (!state)
     return 1;
 
-  const int unknown_width = MeasureText("?", 20);
-  const int font_size = state.config.app_size / 2;
+  // Estimated draw calls of the last frame
+  int last_draw_calls = 0;
+  bool was_fading = false;
 
   state.prevoius_time = GetTime();
 
@@ -33,23 +48,15 @@ int main(void) {
         (IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL)))
       break;
 
-    auto current_time = std::chrono::steady_clock::now();
-    auto elapsed_time = std::chrono::duration_cast<std::chrono::milliseconds>(
-        current_time - state.last_command_time);
-
-    double delta_time = GetTime() - state.prevoius_time;
-    if (delta_time < FPS(state.fps))
-      usleep((FPS(state.fps) - delta_time) * 1000000);
-
-    state.prevoius_time = GetTime();
+    state.worker.stats.render++;
 
-    if (elapsed_time >= state.command_interval) {
-      state.last_command_time = current_time;
-      state.mouse_pos = hyprland::command::get_mouse_position(state.sock_path);
-      state.active_workspace =
-          hyprland::command::get_active_workspace(state.sock_path);
+    if (auto snapshot = state.worker.poll_snapshot()) {
+      auto current_time = std::chrono::steady_clock::now();
+      state.apply_snapshot(std::move(*snapshot));
 
-      if (state.is_valid_mouse_pos()) {
+      // The trigger strip handles the reveal from pointer events instead
+      bool polled_reveal = !state.config.edge_trigger || !state.is_minimized;
+      if (polled_reveal && state.is_valid_mouse_pos()) {
         if (state.is_hovering()) {
           if (state.should_wait()) {
             state.start_waiting();
@@ -58,140 +65,210 @@ int main(void) {
               if (std::chrono::duration_cast<std::chrono::milliseconds>(
                       current_time - state.start_wait_time) >=
                   state.wait_interval) {
-                hyprland::command::move_window_to_workspace(
-                    state.uuid, state.active_workspace, state.sock_path);
-                hyprland::command::move_mouse(state.mouse_pos, state.sock_path);
-                SetWindowPosition(state.window_x, state.window_y);
-                state.is_minimized = false;
-                state.waiting = false;
+                state.reveal();
               }
             } else {
               state.start_waiting();
             }
           }
         } else if (!state.is_minimized) {
-          hyprland::command::hide_window(state.uuid, state.sock_path);
-          SetWindowPosition(state.window_x, state.window_y);
-          state.is_minimized = true;
-          // Deselect app if the window gets hidden
-          state.clicked_app = -1;
+          state.hide();
+        }
+      }
+    }
+
+    if (state.is_minimized && state.config.edge_trigger) {
+      if (state.dirty) {
+        BeginDrawing();
+        ClearBackground(BLANK);
+        EndDrawing();
+        state.dirty = false;
+      }
+
+      if (IsCursorOnScreen()) {
+        // Same stability check as the polled reveal, using the position
+        // reported by the pointer events on the strip
+        Vector2 strip_mouse_pos = GetMousePosition();
+        state.mouse_pos = {
+            state.window_x + static_cast<int>(strip_mouse_pos.x),
+            state.monitor.height - TRIGGER_HEIGHT +
+                static_cast<int>(strip_mouse_pos.y),
+        };
+
+        if (state.should_wait() || state.mouse_pos != state.wait_mouse_pos) {
+          state.start_waiting();
+        } else if (std::chrono::steady_clock::now() - state.start_wait_time >=
+                   state.wait_interval) {
+          state.reveal();
+          continue;
         }
+
+        // Check again every frame until wait_time has passed
+        DisableEventWaiting();
+        WaitTime(FPS(state.fps));
+      } else {
+        // Sleeps until the pointer enters the strip
+        state.waiting = false;
+        hyprdock::wait_for_events();
+        continue;
       }
+
+      PollInputEvents();
+      continue;
     }
 
     if (state.is_minimized) {
-      if (state.first_frame)
+      if (state.first_frame) {
         state.first_frame = false;
-      else
+      } else {
+        // Sleeps until the IPC worker publishes a new snapshot
+        hyprdock::wait_for_events();
         continue;
+      }
     }
 
-    BeginDrawing();
-    ClearBackground(state.config.dock_color);
+    // Update hover, click and animation state
+    Vector2 win_mouse_pos = GetMousePosition();
+    auto now = std::chrono::steady_clock::now();
+    int hovered_app = -1;
+    for (size_t i = 0; i < state.get_app_count(); i++) {
+      int index = static_cast<int>(i);
+      bool hovered =
+          CheckCollisionPointRec(win_mouse_pos, state.get_app_rect(index));
+      if (hovered)
+        hovered_app = index;
+      state.animations.set_active(i, hovered, now);
+    }
 
-    bool hover = false;
-    int cursor = state.config.dock_padding;
-    for (int i = 0; i < state.config.applications.size(); i++) {
-      const auto &app = state.config.applications[i];
-      const auto &icon = state.app_icons[app.name];
-
-      Rectangle overlay_rect{
-          static_cast<float>(cursor),
-          static_cast<float>(state.config.dock_padding),
-          static_cast<float>(state.config.app_size),
-          static_cast<float>(state.config.app_size),
-      };
-
-      Rectangle icon_rect{
-          overlay_rect.x + 2,
-          overlay_rect.y + 2,
-          overlay_rect.width - 4,
-          overlay_rect.height - 4,
-      };
-
-      // Draw hover/click overlay
-      Vector2 win_mouse_pos = GetMousePosition();
-      if (CheckCollisionPointRec(win_mouse_pos, overlay_rect)) {
-        SetMouseCursor(MOUSE_CURSOR_POINTING_HAND);
-        hover = true;
-        if (state.animations[i] < OVERLAY_OPACITY)
-          state.animations[i] =
-              std::clamp(state.animations[i] + FADE_IN(state.fps), 0, 50);
-
-        Color overlay{180, 180, 180, state.animations[i]};
-        if (IsMouseButtonDown(MOUSE_BUTTON_LEFT))
-          overlay = Color{150, 150, 150, state.animations[i]};
-
-        DrawRectangleRounded(overlay_rect, 0.1, 0, overlay);
-
-        // Launch app only if start click is is on the app and release is on the
-        // app as well
-        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
-          state.clicked_app = i;
-        } else if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
-          if (state.clicked_app == i) {
-            // If the app is running focus it else run new process
-            std::string window = hyprland::command::get_window_from_proc(
-                app.exec, state.sock_path);
-            if (window.empty()) {
-              hyprdock::run_app(app);
-            } else {
-              hyprland::command::focus_window(window, state.sock_path);
-              hyprland::command::move_window_to_workspace(state.uuid, "",
-                                                          state.sock_path);
-              hyprland::command::move_mouse(state.mouse_pos, state.sock_path);
-            }
-          }
-          state.clicked_app = -1;
-        }
-      } else if (state.animations[i] > 0) {
-        state.animations[i] =
-            std::clamp(state.animations[i] - FADE_OUT(state.fps), 0, 50);
-        DrawRectangleRounded(overlay_rect, 0.1, 0,
-                             Color{180, 180, 180, state.animations[i]});
-      }
+    if (hovered_app != state.hovered_app) {
+      state.hovered_app = hovered_app;
+      state.dirty = true;
+      SetMouseCursor(hovered_app >= 0 ? MOUSE_CURSOR_POINTING_HAND
+                                      : MOUSE_CURSOR_DEFAULT);
+    }
 
-      // Draw app icon
-      if (icon.id == 0) {
-        DrawText("?",
-                 overlay_rect.x + (state.config.app_size - unknown_width) / 2,
-                 overlay_rect.y + (state.config.app_size - font_size) / 2,
-                 font_size, LIGHTGRAY);
-      } else {
-        DrawTexturePro(icon,
-                       Rectangle{0.0f, 0.0f, static_cast<float>(icon.width),
-                                 static_cast<float>(icon.height)},
-                       icon_rect, Vector2{0, 0}, 0.0f, WHITE);
+    // Launch app only if start click is is on the app and release is on the
+    // app as well
+    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+      state.clicked_app = hovered_app;
+      state.dirty = true;
+    } else if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
+      if (hovered_app >= 0 && state.clicked_app == hovered_app) {
+        state.worker.send({
+            .type = hyprdock::RequestType::Activate,
+            .mouse_pos = state.mouse_pos,
+            .app = static_cast<size_t>(hovered_app),
+            .app_id = state.get_app(hovered_app).id,
+        });
       }
+      state.clicked_app = -1;
+      state.dirty = true;
+    }
 
-      // Draw active dot
-      if (elapsed_time >= state.command_interval) {
-        if (!hyprland::command::get_window_from_proc(app.exec, state.sock_path)
-                 .empty()) {
-          DrawCircle(overlay_rect.x + overlay_rect.width / 2,
-                     overlay_rect.y + overlay_rect.height +
-                         state.config.dock_padding - 5,
-                     3, Color{0, 182, 255, 255});
-          state.active_cache[i] = true;
-        } else {
-          state.active_cache[i] = false;
-        }
-      } else {
-        if (state.active_cache[i])
-          DrawCircle(overlay_rect.x + overlay_rect.width / 2,
-                     overlay_rect.y + overlay_rect.height +
-                         state.config.dock_padding - 5,
-                     3, Color{0, 182, 255, 255});
+    // One more frame after the fades settle draws their final values
+    bool fading = state.animations.is_active(now);
+    bool pulsing = state.is_launching();
+    bool settling = was_fading && !fading;
+    was_fading = fading;
+    if (!state.dirty && !fading && !settling) {
+      // Launch dots only pulse at a low rate, a launch can stay pending for
+      // a long time and must not keep the dock drawing at the refresh rate
+      double until_pulse =
+          state.prevoius_time + 1.0 / LAUNCH_PULSE_FPS - GetTime();
+      if (!pulsing) {
+        // Nothing changed, block until input or a new IPC snapshot arrives
+        hyprdock::wait_for_events();
+        continue;
+      } else if (until_pulse > 0.0) {
+        DisableEventWaiting();
+        WaitTime(until_pulse);
+        PollInputEvents();
+        continue;
       }
+    }
+
+    // Keep frames flowing while an overlay fades or a launch dot pulses
+    if (fading || pulsing)
+      DisableEventWaiting();
+    else
+      hyprdock::enable_event_waiting();
+
+    double delta_time = GetTime() - state.prevoius_time;
+    if (delta_time < FPS(state.fps))
+      usleep((FPS(state.fps) - delta_time) * 1000000);
+
+    state.prevoius_time = GetTime();
+
+    // Icons and dots only change with the running state, everything but
+    // the fading overlays comes from the retained layer
+    if (state.layer_dirty) {
+      state.render_static_layer();
+      if (state.options.draw_calls)
+        std::println("[DEBUG] Static layer redrawn");
+    }
+
+    BeginDrawing();
+    ClearBackground(state.config.dock_color);
+
+    const Texture2D &layer = state.static_layer.texture;
+    DrawCounter draw_calls;
+
+    // Render textures are stored upside down, the layer has the pixel
+    // density of the icons and is scaled to the window
+    DrawTexturePro(layer,
+                   Rectangle{0.0f, 0.0f, static_cast<float>(layer.width),
+                             -static_cast<float>(layer.height)},
+                   Rectangle{0.0f, 0.0f, static_cast<float>(state.dock_width),
+                             static_cast<float>(state.dock_height)},
+                   Vector2{0, 0}, 0.0f, WHITE);
+    draw_calls.use(layer.id);
+
+    // Sample the fades at the time the frame is actually drawn
+    now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < state.get_app_count(); i++) {
+      auto alpha = static_cast<unsigned char>(
+          std::lround(state.animations.get_value(i, now) * OVERLAY_OPACITY));
+      if (alpha == 0)
+        continue;
 
-      // Move draw cursor
-      cursor += state.config.app_size + state.config.app_padding;
+      // Draw hover/click overlay between the background and the icon
+      int index = static_cast<int>(i);
+      Rectangle overlay_rect = state.get_app_rect(index);
+      Color overlay{180, 180, 180, alpha};
+      if (index == hovered_app && IsMouseButtonDown(MOUSE_BUTTON_LEFT))
+        overlay = Color{150, 150, 150, alpha};
+
+      DrawRectangleRec(overlay_rect, state.config.dock_color);
+      DrawRectangleRounded(overlay_rect, 0.1, 0, overlay);
+      state.draw_icon(index);
+      draw_calls.use(state.atlas.get_texture().id);
     }
 
-    if (!hover)
-      SetMouseCursor(MOUSE_CURSOR_DEFAULT);
+    // Pulse the dot of launched apps until their first window maps
+    double pulse =
+        0.5 + 0.5 * std::sin(GetTime() * 2.0 * std::numbers::pi /
+                             LAUNCH_PULSE_PERIOD);
+    for (size_t i = 0; i < state.launching.size(); i++) {
+      if (!state.launching[i])
+        continue;
+
+      Rectangle app_rect = state.get_app_rect(static_cast<int>(i));
+      DrawCircle(app_rect.x + app_rect.width / 2,
+                 app_rect.y + app_rect.height + state.config.dock_padding - 5,
+                 3,
+                 Color{0, 182, 255, static_cast<unsigned char>(pulse * 255)});
+      draw_calls.use(state.atlas.get_texture().id);
+    }
+
+    state.dirty = false;
 
     EndDrawing();
+
+    if (state.options.draw_calls && draw_calls.calls != last_draw_calls) {
+      std::println("[DEBUG] Estimated draw calls per frame: {}",
+                   draw_calls.calls);
+      last_draw_calls = draw_calls.calls;
+    }
   }
 
   state.unload();
@@ -0,0 +1,111 @@
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "commands.hpp"
+#include "launcher.hpp"
+#include "matcher.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+namespace hyprdock {
+
+AppMatcher::AppMatcher(const std::vector<DesktopEntry> &apps)
+    : app_count(apps.size()) {
+  // Earlier keys win, StartupWMClass is what the app says its class is
+  // while the executable name is only a guess
+  for (size_t i = 0; i < apps.size(); i++) {
+    if (!apps[i].startup_wm_class.empty())
+      this->by_class.emplace(to_lower(apps[i].startup_wm_class), i);
+  }
+
+  for (size_t i = 0; i < apps.size(); i++) {
+    if (!apps[i].id.empty())
+      this->by_class.emplace(to_lower(apps[i].id), i);
+  }
+
+  for (size_t i = 0; i < apps.size(); i++) {
+    std::string executable = get_exec_name(apps[i].exec);
+    if (executable.empty())
+      continue;
+
+    this->by_class.emplace(to_lower(executable), i);
+    this->by_executable.emplace(executable, i);
+  }
+}
+
+std::vector<const Client *>
+AppMatcher::match(const ClientSnapshot &clients,
+                  std::vector<const Client *> *unmatched) {
+  std::vector<const Client *> windows(this->app_count, nullptr);
+  std::unordered_set<pid_t> live_pids;
+  // Windows of one process share a single /proc lookup per snapshot
+  std::unordered_map<pid_t, std::optional<size_t>> proc_matches;
+
+  for (const auto &client : clients.get_clients()) {
+    live_pids.insert(client.pid);
+
+    auto app = this->find_by_class(client);
+    if (!app) {
+      auto [it, inserted] = proc_matches.try_emplace(client.pid);
+      if (inserted)
+        it->second = this->find_by_proc(client.pid);
+      app = it->second;
+    }
+
+    if (app && !windows[*app])
+      windows[*app] = &client;
+    else if (!app && unmatched)
+      unmatched->push_back(&client);
+  }
+
+  this->prune(live_pids);
+  return windows;
+}
+
+void AppMatcher::prune(const std::unordered_set<pid_t> &live_pids) {
+  prune_pid_cache(live_pids);
+}
+
+std::optional<size_t> AppMatcher::find(const Client &client) {
+  if (auto app = this->find_by_class(client))
+    return app;
+
+  return this->find_by_proc(client.pid);
+}
+
+std::optional<size_t> AppMatcher::find_by_class(const Client &client) const {
+  for (const auto *class_name : {&client.class_name, &client.initial_class}) {
+    if (class_name->empty())
+      continue;
+
+    auto it = this->by_class.find(to_lower(*class_name));
+    if (it != this->by_class.end())
+      return it->second;
+  }
+
+  return std::nullopt;
+}
+
+std::optional<size_t> AppMatcher::find_by_proc(pid_t pid) const {
+  // Not cached across snapshots here, the pid cache checks the process start
+  // time so a reused pid is never matched to the app of the process it
+  // replaced
+  std::string proc = get_name_from_pid(pid);
+  if (proc.empty())
+    return std::nullopt;
+
+  auto it = this->by_executable.find(fs::path{proc}.filename().string());
+  if (it == this->by_executable.end())
+    return std::nullopt;
+
+  return it->second;
+}
+
+} // namespace hyprdock
@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include "scheduler.hpp"
+
+namespace hyprdock {
+
+void PollScheduler::configure(Query query, std::chrono::milliseconds min,
+                              std::chrono::milliseconds max) {
+  PollRate &rate = this->rate(query);
+  rate.min = min;
+  rate.max = max;
+  rate.current = min;
+}
+
+void PollScheduler::set_enabled(Query query, bool enabled) {
+  PollRate &rate = this->rate(query);
+  if (enabled && !rate.enabled)
+    rate.next_due = Clock::now();
+
+  rate.enabled = enabled;
+}
+
+void PollScheduler::reset(Query query) {
+  PollRate &rate = this->rate(query);
+  rate.current = rate.min;
+  // Never later than already scheduled, a query just enabled stays due
+  rate.next_due = std::min(rate.next_due, rate.last_poll + rate.current);
+}
+
+void PollScheduler::back_off(Query query, std::chrono::milliseconds limit) {
+  PollRate &rate = this->rate(query);
+  auto upper = std::max(rate.min, std::min(limit, rate.max));
+  rate.current = std::min(rate.current * 2, upper);
+  rate.next_due = rate.last_poll + rate.current;
+}
+
+bool PollScheduler::is_due(Query query, Clock::time_point now) const {
+  const PollRate &rate = this->get_rate(query);
+  return rate.enabled && now >= rate.next_due;
+}
+
+void PollScheduler::mark_polled(Query query, Clock::time_point now) {
+  PollRate &rate = this->rate(query);
+  rate.polls++;
+  rate.last_poll = now;
+  rate.next_due = now + rate.current;
+}
+
+std::optional<PollScheduler::Clock::time_point>
+PollScheduler::next_deadline(void) const {
+  std::optional<Clock::time_point> deadline;
+  for (const auto &rate : this->rates) {
+    if (rate.enabled && (!deadline || rate.next_due < *deadline))
+      deadline = rate.next_due;
+  }
+
+  return deadline;
+}
+
+uint64_t PollScheduler::take_polls(Query query) {
+  return std::exchange(this->rate(query).polls, 0);
+}
+
+} // namespace hyprdock
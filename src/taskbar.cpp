@@ -0,0 +1,121 @@
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "cache.hpp"
+#include "commands.hpp"
+#include "matcher.hpp"
+#include "taskbar.hpp"
+#include "utils.hpp"
+
+namespace hyprdock {
+
+void Taskbar::start(const std::string &uuid, int icon_size,
+                    DesktopCache desktop_cache) {
+  this->uuid = uuid;
+  this->icon_size = icon_size;
+  this->desktop_cache.emplace(std::move(desktop_cache));
+  this->matcher = AppMatcher{this->desktop_cache->get_index().get_entries()};
+  this->apps = std::make_shared<const std::vector<DesktopEntry>>();
+}
+
+void Taskbar::stop(void) {
+  // Icons resolved for apps that showed up are kept for the next run
+  if (this->desktop_cache)
+    this->desktop_cache->save();
+}
+
+bool Taskbar::update(const ClientSnapshot &clients,
+                     const std::vector<const Client *> &unmatched) {
+  if (!this->desktop_cache)
+    return false;
+
+  // Group the windows by app, a client without a desktop entry is its own
+  // app keyed by class
+  const auto &entries = this->desktop_cache->get_index().get_entries();
+  std::vector<std::pair<std::string, std::optional<size_t>>> seen;
+  std::unordered_map<std::string, const Client *> first_windows;
+  for (const Client *client : unmatched) {
+    if (client->title == this->uuid)
+      continue;
+
+    auto entry = this->matcher.find(*client);
+    std::string id = entry ? entries[*entry].id
+                           : to_lower(!client->class_name.empty()
+                                          ? client->class_name
+                                          : client->initial_class);
+    if (id.empty())
+      continue;
+
+    if (first_windows.emplace(id, client).second)
+      seen.emplace_back(std::move(id), entry);
+  }
+
+  std::unordered_set<pid_t> live_pids;
+  for (const auto &client : clients.get_clients())
+    live_pids.insert(client.pid);
+  this->matcher.prune(live_pids);
+
+  // Apps that are still running keep their place, new ones are appended
+  std::vector<DesktopEntry> apps;
+  std::unordered_set<std::string> kept;
+  for (const auto &app : *this->apps) {
+    if (first_windows.contains(app.id)) {
+      apps.push_back(app);
+      kept.insert(app.id);
+    }
+  }
+
+  bool changed = apps.size() != this->apps->size();
+  for (const auto &[id, entry] : seen) {
+    if (kept.contains(id))
+      continue;
+
+    apps.push_back(this->resolve(*first_windows[id], id, entry));
+    changed = true;
+  }
+
+  this->windows.clear();
+  for (const auto &app : apps)
+    this->windows.push_back(first_windows[app.id]);
+
+  if (changed)
+    this->apps =
+        std::make_shared<const std::vector<DesktopEntry>>(std::move(apps));
+  return changed;
+}
+
+const Client *Taskbar::find_window(const std::string &id) const {
+  for (size_t i = 0; i < this->size(); i++) {
+    if ((*this->apps)[i].id == id)
+      return this->windows[i];
+  }
+
+  return nullptr;
+}
+
+DesktopEntry Taskbar::resolve(const Client &client, const std::string &id,
+                              std::optional<size_t> entry) {
+  DesktopEntry app;
+  if (entry) {
+    app = this->desktop_cache->get_index().get_entries()[*entry];
+  } else {
+    // Most apps without a desktop file still name their icon after the class
+    app.id = id;
+    app.name = !client.class_name.empty() ? client.class_name
+                                          : client.initial_class;
+    app.icon_name = id;
+  }
+
+  app.icon =
+      this->desktop_cache->resolve_icon(app.icon_name, this->icon_size);
+  return app;
+}
+
+} // namespace hyprdock
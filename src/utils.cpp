@@ -19,8 +19,11 @@
 #include <string_view>
 #include <sys/types.h>
 #include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "icons.hpp"
 #include "utils.hpp"
 
 namespace fs = std::filesystem;
@@ -35,6 +38,12 @@ std::string trim(const std::string &str) {
   return str.substr(first, (last - first + 1));
 }
 
+std::string to_lower(std::string str) {
+  std::transform(str.begin(), str.end(), str.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return str;
+}
+
 std::vector<fs::path> get_xdg_data_dirs() {
   std::vector<fs::path> paths;
 
@@ -67,19 +76,82 @@ std::vector<fs::path> get_xdg_data_dirs() {
   return paths;
 }
 
-std::string get_name_from_pid(const std::string &pid) {
-  std::string link_path = "/proc/" + pid + "/exe";
+struct PidCacheEntry {
+  unsigned long long start_time;
+  std::string exe;
+};
+
+// Executables of the pids in the current client list, pruned on every
+// refresh. Pruning alone does not rule out pid reuse between two refreshes,
+// so every entry is checked against the process start time.
+static std::unordered_map<pid_t, PidCacheEntry> pid_cache;
+
+// Field 22 of /proc/<pid>/stat, used to detect pid reuse
+static std::optional<unsigned long long> get_start_time(pid_t pid) {
+  std::ifstream stat_file{"/proc/" + std::to_string(pid) + "/stat"};
+  if (!stat_file.is_open())
+    return std::nullopt;
+
+  std::string stat;
+  std::getline(stat_file, stat);
+
+  // The command name may contain spaces and parentheses, fields after it are
+  // counted from the last ')'
+  size_t comm_end = stat.rfind(')');
+  if (comm_end == std::string::npos)
+    return std::nullopt;
+
+  std::istringstream fields{stat.substr(comm_end + 1)};
+  std::string field;
+  for (int i = 3; i < 22; i++)
+    if (!(fields >> field))
+      return std::nullopt;
+
+  unsigned long long start_time;
+  if (!(fields >> start_time))
+    return std::nullopt;
+
+  return start_time;
+}
+
+std::string get_name_from_pid(pid_t pid) {
+  auto start_time = get_start_time(pid);
+  if (!start_time) {
+    // Process exited, nothing to resolve
+    pid_cache.erase(pid);
+    return "";
+  }
+
+  // Only skip the readlink for the same process that was resolved before
+  auto it = pid_cache.find(pid);
+  if (it != pid_cache.end() && it->second.start_time == *start_time)
+    return it->second.exe;
+
+  std::string link_path = "/proc/" + std::to_string(pid) + "/exe";
   char buffer[PATH_MAX];
   ssize_t len = readlink(link_path.c_str(), buffer, sizeof(buffer) - 1);
 
-  if (len < 0) {
+  std::string exe;
+  if (len >= 0) {
+    buffer[len] = '\0';
+    exe = buffer;
+  } else if (errno == ENOENT) {
+    pid_cache.erase(pid);
+    return "";
+  } else {
+    // Failures are cached as well so they are only reported once per process
     std::println(std::cerr, "[ERROR] Failed to read symlink {}: {}", link_path,
                  strerror(errno));
-    return "";
   }
 
-  buffer[len] = '\0';
-  return std::string{buffer};
+  pid_cache[pid] = PidCacheEntry{.start_time = *start_time, .exe = exe};
+  return exe;
+}
+
+void prune_pid_cache(const std::unordered_set<pid_t> &live_pids) {
+  std::erase_if(pid_cache, [&live_pids](const auto &entry) {
+    return !live_pids.contains(entry.first);
+  });
 }
 
 std::string generate_id() {
@@ -94,53 +166,34 @@ std::string generate_id() {
   return ss.str();
 }
 
-std::string resolve_app_icon(const std::string &icon_name, int desired_size) {
+static std::string find_app_icon(const std::string &icon_name,
+                                 int desired_size) {
   fs::path test_path{icon_name};
   if (test_path.is_absolute() && fs::exists(test_path) &&
       fs::is_regular_file(test_path))
     return test_path.string();
 
-  const std::vector<std::string> categories = {"apps", "status", "devices",
-                                               "mimetypes"};
-
-  std::vector<fs::path> icon_base_dirs;
-  for (const auto &xdg_dir : get_xdg_data_dirs())
-    icon_base_dirs.push_back(xdg_dir / "icons");
-
-  icon_base_dirs.push_back("/usr/share/pixmaps");
+  std::string icon_path = get_icon_lookup().find(icon_name, desired_size);
+  if (icon_path.empty())
+    std::println("[WARNING] Icon not found for: {}", icon_name);
 
-  const std::vector<std::string> themes = {"Adwaita", "hicolor", "gnome"};
-  std::vector<int> sizes_to_check = {desired_size, 64,  48,  32, 24,
-                                     16,           128, 256, 512};
-  std::sort(sizes_to_check.begin(), sizes_to_check.end(),
-            [desired_size](int a, int b) {
-              return std::abs(a - desired_size) < std::abs(b - desired_size);
-            });
+  return icon_path;
+}
 
-  for (const auto &base_dir : icon_base_dirs) {
-    if (!fs::exists(base_dir) || !fs::is_directory(base_dir))
-      continue;
+std::string resolve_app_icon(const std::string &icon_name, int desired_size) {
+  if (icon_name.empty())
+    return "";
 
-    for (const auto &theme_name : themes) {
-      fs::path theme_path = base_dir / theme_name;
-      if (!fs::exists(theme_path) || !fs::is_directory(theme_path))
-        continue;
-
-      for (int size : sizes_to_check) {
-        std::string size_str =
-            std::to_string(size) + "x" + std::to_string(size);
-        for (const auto &category : categories) {
-          fs::path potential_path =
-              theme_path / size_str / category / (icon_name + ".png");
-          if (fs::exists(potential_path) && fs::is_regular_file(potential_path))
-            return potential_path.string();
-        }
-      }
-    }
-  }
+  // Apps sharing an icon only pay for the theme search once
+  static std::unordered_map<std::string, std::string> resolved_icons;
+  std::string cache_key = icon_name + "@" + std::to_string(desired_size);
+  auto it = resolved_icons.find(cache_key);
+  if (it != resolved_icons.end())
+    return it->second;
 
-  std::println("[WARNING] Icon not found for: {}", icon_name);
-  return "";
+  std::string icon_path = find_app_icon(icon_name, desired_size);
+  resolved_icons.emplace(std::move(cache_key), icon_path);
+  return icon_path;
 }
 
 std::optional<DesktopEntry> parse_desktop_file(const fs::path &path) {
@@ -149,6 +202,8 @@ std::optional<DesktopEntry> parse_desktop_file(const fs::path &path) {
     return std::nullopt;
 
   DesktopEntry entry;
+  entry.path = path.string();
+
   std::string line;
   bool in_desktop_entry_section = false;
 
@@ -179,9 +234,11 @@ std::optional<DesktopEntry> parse_desktop_file(const fs::path &path) {
         else if (key == "Comment")
           entry.comment = value;
         else if (key == "Icon")
-          entry.icon = resolve_app_icon(value);
+          entry.icon_name = value;
         else if (key == "Exec")
-          entry.exec = get_first_token(value);
+          entry.exec = value;
+        else if (key == "StartupWMClass")
+          entry.startup_wm_class = value;
         else if (key == "NoDisplay")
           entry.no_display = (value == "true");
         else if (key == "Hidden")
@@ -198,98 +255,4 @@ std::optional<DesktopEntry> parse_desktop_file(const fs::path &path) {
   return entry;
 }
 
-std::optional<DesktopEntry> get_entry_for_name(const std::string &name) {
-  std::vector<fs::path> search_dirs;
-
-  const char *xdg_data_home = std::getenv("XDG_DATA_HOME");
-  if (xdg_data_home && std::strlen(xdg_data_home) > 0) {
-    search_dirs.push_back(fs::path(xdg_data_home) / "applications");
-  } else {
-    const char *home_dir = std::getenv("HOME");
-    if (home_dir && std::strlen(home_dir) > 0)
-      search_dirs.push_back(fs::path(home_dir) / ".local" / "share" /
-                            "applications");
-  }
-
-  const char *xdg_data_dirs = std::getenv("XDG_DATA_DIRS");
-  if (xdg_data_dirs && std::strlen(xdg_data_dirs) > 0) {
-    std::string_view dirs_str(xdg_data_dirs);
-    size_t start = 0;
-    size_t end = dirs_str.find(":");
-    while (end != std::string_view::npos) {
-      search_dirs.push_back(fs::path(dirs_str.substr(start, end - start)) /
-                            "applications");
-      start = end + 1;
-      end = dirs_str.find(":", start);
-    }
-    search_dirs.push_back(fs::path(dirs_str.substr(start)) / "applications");
-  } else {
-    search_dirs.push_back("/usr/share/applications");
-    search_dirs.push_back("/usr/local/share/applications");
-  }
-
-  std::string search_name_lower = name;
-  std::transform(search_name_lower.begin(), search_name_lower.end(),
-                 search_name_lower.begin(),
-                 [](unsigned char c) { return std::tolower(c); });
-
-  for (const auto &dir : search_dirs) {
-    if (!fs::exists(dir) || !fs::is_directory(dir))
-      continue;
-
-    for (const auto &entry : fs::directory_iterator(dir)) {
-      if (entry.is_regular_file() && entry.path().extension() == ".desktop") {
-        auto desktop_entry_opt = parse_desktop_file(entry.path());
-
-        if (desktop_entry_opt) {
-          DesktopEntry current_entry = *desktop_entry_opt;
-
-          if (current_entry.no_display || current_entry.hidden)
-            continue;
-
-          std::string entry_name_lower = current_entry.name;
-          std::transform(entry_name_lower.begin(), entry_name_lower.end(),
-                         entry_name_lower.begin(),
-                         [](unsigned char c) { return std::tolower(c); });
-
-          if (entry_name_lower == search_name_lower)
-            return current_entry;
-
-          std::string filename_without_ext = entry.path().stem().string();
-          std::transform(filename_without_ext.begin(),
-                         filename_without_ext.end(),
-                         filename_without_ext.begin(),
-                         [](unsigned char c) { return std::tolower(c); });
-
-          if (filename_without_ext == search_name_lower)
-            return current_entry;
-        }
-      }
-    }
-  }
-
-  return std::nullopt;
-}
-
-std::string get_first_token(const std::string &str) {
-  size_t first_space_pos = str.find(' ');
-  if (first_space_pos == std::string::npos)
-    return str;
-
-  return str.substr(0, first_space_pos);
-}
-
-void run_app(const DesktopEntry &app) {
-  pid_t pid = fork();
-  if (pid == -1) {
-    perror("Failed to fork process for app launch");
-  } else if (pid == 0) {
-    execlp(app.exec.c_str(), app.exec.c_str(), NULL);
-    perror("Failed to execute command in child process");
-    _exit(1);
-  } else {
-    std::println("[INFO] Launched app {} with pid {}", app.name, pid);
-  }
-}
-
 } // namespace hyprdock
@@ -0,0 +1,461 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <poll.h>
+#include <print>
+#include <pthread.h>
+#include <string>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "commands.hpp"
+#include "events.hpp"
+#include "ipc.hpp"
+#include "latency.hpp"
+#include "launcher.hpp"
+#include "matcher.hpp"
+#include "scheduler.hpp"
+#include "taskbar.hpp"
+#include "utils.hpp"
+#include "worker.hpp"
+
+namespace hyprdock {
+
+static void notify_fd(int fd) {
+  uint64_t one = 1;
+  [[maybe_unused]] ssize_t written = write(fd, &one, sizeof(one));
+}
+
+static void drain_fd(int fd) {
+  uint64_t count;
+  [[maybe_unused]] ssize_t bytes_read = read(fd, &count, sizeof(count));
+}
+
+// One-shot timer at an absolute steady_clock time, no deadline disarms it
+static bool
+arm_timer(int fd, std::optional<PollScheduler::Clock::time_point> deadline) {
+  struct itimerspec spec{};
+  if (deadline) {
+    auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        deadline->time_since_epoch());
+    spec.it_value.tv_sec = since_epoch.count() / 1000000000;
+    spec.it_value.tv_nsec = since_epoch.count() % 1000000000;
+    // A zero value would disarm the timer instead of firing right away
+    if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0)
+      spec.it_value.tv_nsec = 1;
+  }
+
+  return timerfd_settime(fd, TFD_TIMER_ABSTIME, &spec, nullptr) == 0;
+}
+
+IpcWorker::~IpcWorker(void) {
+  this->stop();
+}
+
+bool IpcWorker::start(WorkerOptions options) {
+  this->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (this->wake_fd < 0) {
+    std::println(std::cerr, "[ERROR] Failed to create IPC worker wake fd");
+    return false;
+  }
+
+  this->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (this->timer_fd < 0) {
+    std::println(std::cerr, "[ERROR] Failed to create IPC worker timer");
+    return false;
+  }
+
+  this->options = std::move(options);
+  this->scheduler.configure(Query::Cursor, this->cursor_interval,
+                            this->cursor_limit);
+  this->scheduler.configure(Query::Workspace, this->fallback_interval,
+                            this->fallback_interval);
+  this->scheduler.configure(Query::Clients, this->fallback_interval,
+                            this->fallback_interval);
+  this->update_cursor_polling();
+  this->active_cache.resize(this->options.apps.size(), false);
+  this->app_windows.resize(this->options.apps.size(), nullptr);
+  this->matcher = AppMatcher{this->options.apps};
+  if (this->options.taskbar && this->options.desktop_cache)
+    this->taskbar.start(this->options.uuid, this->options.icon_size,
+                        std::move(*this->options.desktop_cache));
+  this->active_workspace =
+      hyprland::command::get_active_workspace(this->options.sock_path);
+
+  // SIGUSR1 prints the launch latencies collected so far
+  sigset_t report_mask;
+  sigemptyset(&report_mask);
+  sigaddset(&report_mask, SIGUSR1);
+  this->report_fd = signalfd(-1, &report_mask, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (this->report_fd < 0) {
+    // Left blocked it would stay pending forever, its default action would
+    // kill the dock, so it is ignored and the latencies print at exit only
+    std::println(std::cerr, "[ERROR] Failed to create SIGUSR1 signalfd: {}",
+                 strerror(errno));
+    signal(SIGUSR1, SIG_IGN);
+    pthread_sigmask(SIG_UNBLOCK, &report_mask, nullptr);
+  }
+  this->launches.resize(this->options.apps.size());
+
+  if (this->options.launch_backend == LaunchBackend::Spawn &&
+      !this->launcher.start())
+    std::println("[WARNING] Launched apps will not be reaped until exit");
+
+  auto event_sock_path = hyprland::IPC::get_event_socket_path();
+  if (!event_sock_path || !this->events.connect(*event_sock_path))
+    std::println("[WARNING] Event socket unavailable, falling back to polling");
+
+  this->running = true;
+  this->thread = std::thread{&IpcWorker::run, this};
+  return true;
+}
+
+void IpcWorker::stop(void) {
+  if (this->running.exchange(false))
+    notify_fd(this->wake_fd);
+
+  if (this->thread.joinable()) {
+    this->thread.join();
+
+    if (this->launches.has_samples())
+      this->launches.print(this->options.apps);
+    this->taskbar.stop();
+  }
+
+  if (this->wake_fd >= 0)
+    close(this->wake_fd);
+  if (this->timer_fd >= 0)
+    close(this->timer_fd);
+
+  this->launcher.stop();
+
+  if (this->report_fd >= 0)
+    close(this->report_fd);
+  this->report_fd = -1;
+
+  this->wake_fd = -1;
+  this->timer_fd = -1;
+}
+
+bool IpcWorker::send(const Request &request) {
+  if (!this->requests.push(request)) {
+    std::println(std::cerr, "[ERROR] IPC request queue is full");
+    return false;
+  }
+
+  notify_fd(this->wake_fd);
+  return true;
+}
+
+std::optional<IpcSnapshot> IpcWorker::poll_snapshot(void) {
+  return this->snapshots.take();
+}
+
+void IpcWorker::run(void) {
+  auto last_stats = std::chrono::steady_clock::now();
+
+  while (this->running) {
+    int timeout = -1;
+    if (this->options.print_stats) {
+      auto until_stats = std::chrono::duration_cast<std::chrono::milliseconds>(
+          last_stats + this->stats_interval - std::chrono::steady_clock::now());
+      timeout = std::max<int>(0, until_stats.count());
+    }
+
+    // Sleep until the poll timer fires, Hyprland sends an event, the
+    // render thread queues a request, a launched app exits or latencies
+    // are requested
+    struct pollfd fds[5] = {
+        {.fd = this->wake_fd, .events = POLLIN, .revents = 0},
+        {.fd = this->timer_fd, .events = POLLIN, .revents = 0},
+        {.fd = this->events.get_fd(), .events = POLLIN, .revents = 0},
+        {.fd = this->launcher.get_fd(), .events = POLLIN, .revents = 0},
+        {.fd = this->report_fd, .events = POLLIN, .revents = 0},
+    };
+
+    if (poll(fds, 5, timeout) < 0 && errno != EINTR) {
+      std::println(std::cerr, "[ERROR] IPC worker poll failed");
+      break;
+    }
+
+    this->stats.worker++;
+
+    if (fds[0].revents & POLLIN)
+      drain_fd(this->wake_fd);
+
+    if (fds[3].revents & POLLIN)
+      this->launcher.reap();
+
+    if (fds[4].revents & POLLIN) {
+      struct signalfd_siginfo info;
+      while (read(this->report_fd, &info, sizeof(info)) == sizeof(info))
+        ;
+      this->launches.print(this->options.apps);
+    }
+
+    bool changed = false;
+    while (auto request = this->requests.pop())
+      changed |= this->handle_request(*request);
+
+    if (fds[2].revents)
+      changed |= this->handle_events();
+
+    if (fds[1].revents & POLLIN) {
+      drain_fd(this->timer_fd);
+      changed |= this->run_due_queries();
+      changed |= this->launches.expire(std::chrono::steady_clock::now());
+    }
+
+    // Fall back to polling if the event socket goes away
+    this->scheduler.set_enabled(Query::Workspace, !this->events.is_connected());
+    this->scheduler.set_enabled(Query::Clients, !this->events.is_connected());
+    this->arm_poll_timer();
+
+    changed |= this->refresh_clients() && this->options.visible;
+    changed |= std::exchange(this->launches_dirty, false);
+
+    if (changed)
+      this->publish();
+
+    auto current_time = std::chrono::steady_clock::now();
+    if (this->options.print_stats &&
+        current_time - last_stats >= this->stats_interval) {
+      this->print_stats(current_time - last_stats);
+      last_stats = current_time;
+    }
+  }
+}
+
+bool IpcWorker::run_due_queries(void) {
+  auto now = PollScheduler::Clock::now();
+  bool changed = false;
+
+  if (this->scheduler.is_due(Query::Cursor, now)) {
+    this->scheduler.mark_polled(Query::Cursor, now);
+    this->mouse_pos =
+        hyprland::command::get_mouse_position(this->options.sock_path);
+
+    // Poll fast while the pointer is close to the hover area. The visible
+    // dock is hidden once a polled position leaves it, so it never backs off.
+    if (this->options.visible || this->get_hover_distance() <= NEAR_DISTANCE)
+      this->scheduler.reset(Query::Cursor);
+    else
+      this->scheduler.back_off(Query::Cursor, this->cursor_limit);
+
+    // While hidden the render thread only cares about the cursor when it
+    // is over the hover area, or just left it
+    bool hovering = this->get_hover_distance() == 0;
+    if (this->options.visible || hovering || this->was_hovering)
+      changed = true;
+    this->was_hovering = hovering;
+  }
+
+  // Without the event socket the workspace and clients have to be polled
+  if (this->scheduler.is_due(Query::Workspace, now)) {
+    this->scheduler.mark_polled(Query::Workspace, now);
+    this->active_workspace =
+        hyprland::command::get_active_workspace(this->options.sock_path);
+    changed |= this->options.visible;
+  }
+
+  if (this->scheduler.is_due(Query::Clients, now)) {
+    this->scheduler.mark_polled(Query::Clients, now);
+    this->clients_dirty = true;
+  }
+
+  return changed;
+}
+
+bool IpcWorker::handle_events(void) {
+  bool changed = false;
+
+  for (const auto &event : this->events.read_events()) {
+    switch (event.type) {
+    case hyprland::events::EventType::Workspace:
+      this->active_workspace = event.args[0];
+      changed = this->options.visible;
+
+      // The trigger strip has to stay on the workspace the user is looking at
+      if (this->options.edge_trigger) {
+        this->refresh_clients();
+
+        hyprland::IPC::Batch batch;
+        hyprland::command::move_window_to_workspace_silent(
+            this->options.uuid, this->active_workspace, this->clients, batch);
+        auto resp = batch.send(this->options.sock_path);
+        if (!resp)
+          std::println(std::cerr, "[ERROR] {}", resp.error());
+      }
+      break;
+    case hyprland::events::EventType::OpenWindow:
+    case hyprland::events::EventType::CloseWindow:
+      this->clients_dirty = true;
+      break;
+    case hyprland::events::EventType::MoveWindow:
+      // Event addresses come without the 0x prefix used by j/clients
+      this->clients.move_client("0x" + event.args[0], event.args[1]);
+      break;
+    case hyprland::events::EventType::ActiveWindow:
+      // Running state does not depend on window focus
+      break;
+    }
+  }
+
+  return changed;
+}
+
+bool IpcWorker::refresh_clients(void) {
+  if (!this->clients_dirty)
+    return false;
+
+  this->clients = hyprland::command::get_clients(this->options.sock_path);
+  std::vector<const Client *> unmatched;
+  this->app_windows = this->matcher.match(
+      this->clients, this->options.taskbar ? &unmatched : nullptr);
+  for (size_t i = 0; i < this->app_windows.size(); i++)
+    this->active_cache[i] = this->app_windows[i] != nullptr;
+  this->clients_dirty = false;
+
+  // Windows of apps already on the taskbar only update their lookup
+  if (this->options.taskbar)
+    this->taskbar.update(this->clients, unmatched);
+
+  if (this->launches.match(this->clients, this->active_cache,
+                           std::chrono::steady_clock::now()))
+    this->launches_dirty = true;
+  return true;
+}
+
+bool IpcWorker::handle_request(const Request &request) {
+  // Clients marked stale by an earlier event or poll are fetched before any
+  // window is looked up, the caller publishes what changed
+  bool changed = this->refresh_clients() && this->options.visible;
+
+  hyprland::IPC::Batch batch;
+  switch (request.type) {
+  case RequestType::Reveal:
+    this->options.visible = true;
+    this->update_cursor_polling();
+    // The trigger strip already is on the active workspace
+    if (this->options.edge_trigger)
+      break;
+
+    hyprland::command::move_window_to_workspace(
+        this->options.uuid, this->active_workspace, this->clients, batch);
+    hyprland::command::move_mouse(request.mouse_pos, batch);
+    break;
+  case RequestType::Hide:
+    this->options.visible = false;
+    this->update_cursor_polling();
+    if (this->options.edge_trigger)
+      break;
+
+    hyprland::command::hide_window(this->options.uuid, this->clients, batch);
+    break;
+  case RequestType::Activate: {
+    // Taskbar apps are running by definition, closed ones are ignored
+    const Client *window =
+        request.app < this->options.apps.size()
+            ? this->app_windows[request.app]
+            : this->taskbar.find_window(request.app_id);
+    if (!window && request.app >= this->options.apps.size())
+      break;
+
+    // If the app is running focus it else run new process
+    if (!window) {
+      const auto &app = this->options.apps[request.app];
+      // Latency is measured from here to the first window of the app
+      auto launch_time = std::chrono::steady_clock::now();
+      if (this->options.launch_backend == LaunchBackend::Hyprland) {
+        hyprland::command::exec(join_shell_command(expand_exec(app)), batch);
+        this->launches.start(request.app, std::nullopt, launch_time);
+        this->launches_dirty = true;
+      } else if (auto pid = this->launcher.spawn(app)) {
+        this->launches.start(request.app, *pid, launch_time);
+        this->launches_dirty = true;
+      }
+    } else {
+      // Follow the focused window to its workspace in the same batch
+      hyprland::command::focus_window(window->address, batch);
+      hyprland::command::move_window_to_workspace(
+          this->options.uuid, window->workspace, this->clients, batch);
+      hyprland::command::move_mouse(request.mouse_pos, batch);
+    }
+    break;
+  }
+  case RequestType::Resize:
+    this->options.hover_area = request.hover_area;
+    break;
+  }
+
+  auto resp = batch.send(this->options.sock_path);
+  if (!resp)
+    std::println(std::cerr, "[ERROR] {}", resp.error());
+
+  return changed;
+}
+
+void IpcWorker::publish(void) {
+  // Taskbar apps always have a window
+  std::vector<bool> running = this->active_cache;
+  running.resize(this->options.apps.size() + this->taskbar.size(), true);
+
+  // Each snapshot carries full state, one the render thread has not taken
+  // yet is simply replaced
+  this->snapshots.store(IpcSnapshot{
+      .mouse_pos = this->mouse_pos,
+      .active_workspace = this->active_workspace,
+      .running = std::move(running),
+      .launching = this->launches.get_pending(),
+      .taskbar = this->taskbar.get_apps(),
+  });
+
+  if (this->options.on_publish)
+    this->options.on_publish();
+}
+
+void IpcWorker::update_cursor_polling(void) {
+  // The edge trigger strip reports the pointer itself while the dock is hidden
+  bool polling = this->options.visible || !this->options.edge_trigger;
+  this->scheduler.set_enabled(Query::Cursor, polling);
+  this->scheduler.reset(Query::Cursor);
+}
+
+void IpcWorker::arm_poll_timer(void) {
+  // Also wake up to give up on launches that never open a window
+  auto deadline = this->scheduler.next_deadline();
+  if (auto expiry = this->launches.next_expiry())
+    deadline = deadline ? std::min(*deadline, *expiry) : *expiry;
+
+  if (!arm_timer(this->timer_fd, deadline))
+    std::println(std::cerr, "[ERROR] Failed to arm IPC worker timer");
+}
+
+void IpcWorker::print_stats(std::chrono::steady_clock::duration elapsed) {
+  double seconds = std::chrono::duration<double>(elapsed).count();
+  std::println("[STATS] {} wakeups/s: worker {:.1f}, render {:.1f}",
+               this->options.visible ? "visible" : "hidden",
+               this->stats.worker.exchange(0) / seconds,
+               this->stats.render.exchange(0) / seconds);
+
+  double minutes = seconds / 60.0;
+  std::println("[STATS] IPC polls/min: cursor {:.1f} (every {} ms), "
+               "workspace {:.1f}, clients {:.1f}",
+               this->scheduler.take_polls(Query::Cursor) / minutes,
+               this->scheduler.get_rate(Query::Cursor).current.count(),
+               this->scheduler.take_polls(Query::Workspace) / minutes,
+               this->scheduler.take_polls(Query::Clients) / minutes);
+}
+
+} // namespace hyprdock
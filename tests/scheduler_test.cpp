@@ -0,0 +1,121 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <print>
+#include <source_location>
+
+#include "scheduler.hpp"
+
+// Checks for PollScheduler, built with -DHYPRDOCK_BUILD_TESTS=ON and run
+// through ctest. Time points are passed in, so no test sleeps.
+
+using namespace std::chrono_literals;
+using hyprdock::PollScheduler;
+using hyprdock::Query;
+
+static int failures = 0;
+
+static void check(bool condition, const char *what,
+                  std::source_location location =
+                      std::source_location::current()) {
+  if (condition)
+    return;
+
+  std::println(std::cerr, "[FAIL] {}:{}: {}", location.file_name(),
+               location.line(), what);
+  failures++;
+}
+
+static PollScheduler make_cursor_scheduler(void) {
+  PollScheduler scheduler;
+  scheduler.configure(Query::Cursor, 100ms, 800ms);
+  scheduler.set_enabled(Query::Cursor, true);
+  return scheduler;
+}
+
+static void test_backed_off_poll_snaps_back(void) {
+  PollScheduler scheduler = make_cursor_scheduler();
+  auto now = PollScheduler::Clock::time_point{} + 10s;
+
+  // Far away from the dock until the interval reaches its maximum
+  for (int i = 0; i < 4; i++) {
+    scheduler.mark_polled(Query::Cursor, now);
+    scheduler.back_off(Query::Cursor, 800ms);
+    now = scheduler.get_rate(Query::Cursor).next_due;
+  }
+  check(scheduler.get_rate(Query::Cursor).current == 800ms,
+        "interval backs off to the maximum");
+
+  // The pointer is near on the next poll, the one after it is at the base
+  // interval and not at the backed off one
+  scheduler.mark_polled(Query::Cursor, now);
+  scheduler.reset(Query::Cursor);
+  check(scheduler.get_rate(Query::Cursor).next_due == now + 100ms,
+        "near after backed off schedules the next poll at the base interval");
+  check(!scheduler.is_due(Query::Cursor, now + 99ms), "not due early");
+  check(scheduler.is_due(Query::Cursor, now + 100ms), "due at the base interval");
+}
+
+static void test_back_off_uses_new_interval(void) {
+  PollScheduler scheduler = make_cursor_scheduler();
+  auto now = PollScheduler::Clock::time_point{} + 10s;
+
+  scheduler.mark_polled(Query::Cursor, now);
+  scheduler.back_off(Query::Cursor, 800ms);
+  check(scheduler.get_rate(Query::Cursor).next_due == now + 200ms,
+        "back off schedules the next poll at the doubled interval");
+
+  // A lower limit caps the interval
+  scheduler.mark_polled(Query::Cursor, now);
+  scheduler.back_off(Query::Cursor, 300ms);
+  check(scheduler.get_rate(Query::Cursor).next_due == now + 300ms,
+        "back off is capped by the limit");
+}
+
+static void test_reset_keeps_enabled_query_due(void) {
+  PollScheduler scheduler;
+  scheduler.configure(Query::Cursor, 100ms, 800ms);
+
+  // Enabling makes the query due at the current time, so this one test uses
+  // the real clock
+  scheduler.mark_polled(Query::Cursor, PollScheduler::Clock::now());
+  scheduler.set_enabled(Query::Cursor, false);
+
+  // Enabled again right after the previous poll, before the base interval
+  scheduler.set_enabled(Query::Cursor, true);
+  scheduler.reset(Query::Cursor);
+  check(scheduler.is_due(Query::Cursor, PollScheduler::Clock::now()),
+        "a query enabled and reset is due right away");
+}
+
+static void test_next_deadline(void) {
+  PollScheduler scheduler = make_cursor_scheduler();
+  scheduler.configure(Query::Clients, 1000ms, 1000ms);
+  scheduler.set_enabled(Query::Clients, true);
+  auto now = PollScheduler::Clock::time_point{} + 10s;
+
+  scheduler.mark_polled(Query::Cursor, now);
+  scheduler.mark_polled(Query::Clients, now);
+  check(scheduler.next_deadline() == now + 100ms,
+        "the earliest enabled query sets the deadline");
+
+  scheduler.set_enabled(Query::Cursor, false);
+  check(scheduler.next_deadline() == now + 1000ms,
+        "disabled queries do not set the deadline");
+
+  check(scheduler.take_polls(Query::Cursor) == 1, "polls are counted");
+  check(scheduler.take_polls(Query::Cursor) == 0, "taking polls resets them");
+}
+
+int main(void) {
+  test_backed_off_poll_snaps_back();
+  test_back_off_uses_new_interval();
+  test_reset_keeps_enabled_query_due();
+  test_next_deadline();
+
+  if (failures > 0)
+    return EXIT_FAILURE;
+
+  std::println("[PASS] scheduler");
+  return EXIT_SUCCESS;
+}